@@ -1,23 +1,122 @@
-void cholesky(tpm_desc A)
+// Priority of a task of step k feeding the panel of step k + distance: the
+// panels of the next lookahead steps come before the rest of the trailing
+// update, the nearest first
+static inline int tpm_cholesky_priority(int distance, int lookahead)
+{
+  return distance <= lookahead ? lookahead + 1 - distance : 0;
+}
+
+// Flat task graph: all the tasks created by the calling thread, in the order
+// of the steps, so that they all depend on each other as siblings. Each one
+// has a priority following its distance to the panel, none if lookahead < 0
+void cholesky(tpm_desc A, int lookahead)
+{
+  int k = 0, m = 0, n = 0;
+  for (k = 0; k < A.nt; k++)
+  {
+    double *tileA = A(k, k);
+    int tempkk = tpm_tile_cols(A, k);
+
+#pragma omp task firstprivate(tileA, tempkk)          \
+    priority(tpm_cholesky_priority(0, lookahead)) \
+    depend(inout : tileA[0 : A.tile_size * A.tile_size])
+    {
+      TPM_application_task_start("potrf");
+
+      LAPACKE_dpotrf(LAPACK_COL_MAJOR, 'U', tempkk, tileA, A.tile_ld);
+
+      TPM_application_task_finish("potrf");
+    }
+
+    for (m = k + 1; m < A.nt; m++)
+    {
+      double *tileB = A(k, m);
+      int tempmm = tpm_tile_cols(A, m);
+
+#pragma omp task firstprivate(tileA, tileB, tempkk, tempmm) \
+    priority(tpm_cholesky_priority(1, lookahead))       \
+    depend(in : tileA[0 : A.tile_size * A.tile_size])   \
+    depend(inout : tileB[0 : A.tile_size * A.tile_size])
+      {
+        TPM_application_task_start("trsm");
+
+        cblas_dtrsm(CblasColMajor, CblasLeft, CblasUpper, CblasTrans,
+                    CblasNonUnit, tempkk, tempmm, 1.0, tileA, A.tile_ld,
+                    tileB, A.tile_ld);
+
+        TPM_application_task_finish("trsm");
+      }
+    }
+
+    for (m = k + 1; m < A.nt; m++)
+    {
+      double *tileB = A(k, m);
+      double *tileC = A(m, m);
+      int tempmm = tpm_tile_cols(A, m);
+
+#pragma omp task firstprivate(tileB, tileC, tempkk, tempmm) \
+    priority(tpm_cholesky_priority(m - k, lookahead))   \
+    depend(in : tileB[0 : A.tile_size * A.tile_size])   \
+    depend(inout : tileC[0 : A.tile_size * A.tile_size])
+      {
+        TPM_application_task_start("syrk");
+
+        cblas_dsyrk(CblasColMajor, CblasUpper, CblasTrans, tempmm, tempkk,
+                    -1.0, tileB, A.tile_ld, 1.0, tileC, A.tile_ld);
+
+        TPM_application_task_finish("syrk");
+      }
+
+      for (n = k + 1; n < m; n++)
+      {
+        double *tileN = A(k, n);
+        double *tileC = A(n, m);
+        int tempnn = tpm_tile_cols(A, n);
+
+#pragma omp task firstprivate(tileN, tileB, tileC, tempkk, tempmm, tempnn) \
+    priority(tpm_cholesky_priority(n - k, lookahead))                  \
+    depend(in : tileN[0 : A.tile_size * A.tile_size],                  \
+           tileB[0 : A.tile_size * A.tile_size])                       \
+    depend(inout : tileC[0 : A.tile_size * A.tile_size])
+        {
+          TPM_application_task_start("gemm");
+
+          cblas_dgemm(CblasColMajor, CblasTrans, CblasNoTrans, tempnn, tempmm,
+                      tempkk, -1.0, tileN, A.tile_ld, tileB, A.tile_ld, 1.0,
+                      tileC, A.tile_ld);
+
+          TPM_application_task_finish("gemm");
+        }
+      }
+    }
+  }
+}
+
+// Tasks of the updates of step k created from inside its potrf task. They
+// are not siblings of the tasks of the next steps, so their dependences with
+// them are not ordered: kept only to compare with the flat task graph
+void cholesky_nested(tpm_desc A)
 {
   int k = 0, m = 0, n = 0;
-  for (k = 0; k < A.matrix_size / A.tile_size; k++)
+  for (k = 0; k < A.nt; k++)
   {
     double *tileA = A(k, k);
+    int tempkk = tpm_tile_cols(A, k);
 
 #pragma omp task \
 depend(inout : tileA[0 : A.tile_size * A.tile_size])
     {
       TPM_application_task_start("potrf");
 
-      LAPACKE_dpotrf(LAPACK_COL_MAJOR, 'U', A.tile_size, tileA, A.tile_size);
+      LAPACKE_dpotrf(LAPACK_COL_MAJOR, 'U', tempkk, tileA, A.tile_ld);
 
       TPM_application_task_finish("potrf");
 
-      for (m = k + 1; m < A.matrix_size / A.tile_size; m++)
+      for (m = k + 1; m < A.nt; m++)
       {
         double *tileA = A(k, k);
         double *tileB = A(k, m);
+        int tempmm = tpm_tile_cols(A, m);
 
 #pragma omp task                                  \
 depend(in : tileA[0 : A.tile_size * A.tile_size]) \
@@ -26,17 +125,18 @@ depend(in : tileA[0 : A.tile_size * A.tile_size]) \
           TPM_application_task_start("trsm");
 
           cblas_dtrsm(CblasColMajor, CblasLeft, CblasUpper, CblasTrans,
-                      CblasNonUnit, A.tile_size, A.tile_size, 1.0, tileA,
-                      A.tile_size, tileB, A.tile_size);
+                      CblasNonUnit, tempkk, tempmm, 1.0, tileA, A.tile_ld,
+                      tileB, A.tile_ld);
 
           TPM_application_task_finish("trsm");
         }
       }
 
-      for (m = k + 1; m < A.matrix_size / A.tile_size; m++)
+      for (m = k + 1; m < A.nt; m++)
       {
         double *tileA = A(k, m);
         double *tileB = A(m, m);
+        int tempmm = tpm_tile_cols(A, m);
 
 #pragma omp task                                  \
 depend(in : tileA[0 : A.tile_size * A.tile_size]) \
@@ -44,9 +144,8 @@ depend(in : tileA[0 : A.tile_size * A.tile_size]) \
         {
           TPM_application_task_start("syrk");
 
-          cblas_dsyrk(CblasColMajor, CblasUpper, CblasTrans, A.tile_size,
-                      A.tile_size, -1.0, tileA, A.tile_size, 1.0, tileB,
-                      A.tile_size);
+          cblas_dsyrk(CblasColMajor, CblasUpper, CblasTrans, tempmm, tempkk,
+                      -1.0, tileA, A.tile_ld, 1.0, tileB, A.tile_ld);
 
           TPM_application_task_finish("syrk");
         }
@@ -56,6 +155,7 @@ depend(in : tileA[0 : A.tile_size * A.tile_size]) \
           double *tileA = A(k, n);
           double *tileB = A(k, m);
           double *tileC = A(n, m);
+          int tempnn = tpm_tile_cols(A, n);
 
 #pragma omp task                                  \
 depend(in : tileA[0 : A.tile_size * A.tile_size], \
@@ -64,9 +164,9 @@ depend(in : tileA[0 : A.tile_size * A.tile_size], \
           {
             TPM_application_task_start("gemm");
 
-            cblas_dgemm(CblasColMajor, CblasTrans, CblasNoTrans, A.tile_size,
-                        A.tile_size, A.tile_size, -1.0, tileA, A.tile_size, tileB,
-                        A.tile_size, 1.0, tileC, A.tile_size);
+            cblas_dgemm(CblasColMajor, CblasTrans, CblasNoTrans, tempnn,
+                        tempmm, tempkk, -1.0, tileA, A.tile_ld, tileB,
+                        A.tile_ld, 1.0, tileC, A.tile_ld);
 
             TPM_application_task_finish("gemm");
           }
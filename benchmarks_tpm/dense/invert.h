@@ -1,77 +1,219 @@
-void invert(double *A, int *ipiv, int matrix_size, int tile_size)
+// Move the L factor of the tile (m, k) of A, source, to the workspace tile
+// dest, leaving the U factor alone in A: the part below the diagonal for a
+// diagonal tile
+static void invert_lacpy(tpm_desc A, tpm_desc L, double *source, double *dest, int m, int k)
 {
-    int lda = matrix_size;
+    int rows = tpm_tile_rows(A, m);
+    int cols = tpm_tile_cols(A, k);
+    for (int j = 0; j < cols; j++)
+    {
+        int first = m == k ? j + 1 : 0;
+        if (first < rows)
+        {
+            memcpy(dest + (size_t)j * L.tile_ld + first, source + (size_t)j * A.tile_ld + first,
+                   sizeof(double) * (rows - first));
+            memset(source + (size_t)j * A.tile_ld + first, 0, sizeof(double) * (rows - first));
+        }
+    }
+}
 
-    for (int i = 0; i < matrix_size; i += tile_size)
+// Inverse of the square tile matrix A in place, from its LU factorization
+// P A = L U: U is inverted in its tiles, then inv(A) = inv(U) inv(L) P is
+// solved for as X L = inv(U), and the column interchanges of P are applied
+// last. The steps depend on each other tile by tile, through the addresses of
+// the tiles of A and of the workspace holding L, so that the inversion of a
+// part of U starts as soon as its factorization is done
+void invert(tpm_desc A, int *ipiv)
+{
+    int tile_size = A.tile_size;
+    char *column = malloc(A.nt);
+    tpm_desc L = tpm_matrix_desc_init(tile_size, A.m, A.n);
+    if (column == NULL || tpm_matrix_desc_alloc(&L))
     {
+        printf("Problem allocating the inversion workspace.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    lu_tasks(A, ipiv, column);
 
-#pragma omp task depend(inout : A[i * tile_size + i])
+    // L to the workspace, once the row interchanges of the later steps are
+    // applied to its tile column, which they write through A(k, k). The
+    // diagonal tile is moved last, after the others read its address
+    for (int k = 0; k < A.nt; k++)
+    {
+        double *akk = A(k, k);
+        for (int m = k + 1; m < A.mt; m++)
         {
-            TPM_application_task_start("getrf");
+            double *amk = A(m, k);
+            double *lmk = L(m, k);
+
+#pragma omp task firstprivate(akk, amk, lmk, m, k) depend(in : akk[0 : tile_size * tile_size]) \
+    depend(inout : amk[0 : tile_size * tile_size]) depend(out : lmk[0 : tile_size * tile_size])
+            {
+                TPM_application_task_start("lacpy");
 
-            LAPACKE_dgetrf(LAPACK_ROW_MAJOR, tile_size, tile_size, &A[i * matrix_size + i], lda, &ipiv[i]);
+                invert_lacpy(A, L, amk, lmk, m, k);
 
-            TPM_application_task_finish("getrf");
+                TPM_application_task_finish("lacpy");
+            }
         }
-        for (int j = i + tile_size; j < matrix_size; j += tile_size)
+
+        double *lkk = L(k, k);
+
+#pragma omp task firstprivate(akk, lkk, k) depend(inout : akk[0 : tile_size * tile_size]) \
+    depend(out : lkk[0 : tile_size * tile_size])
         {
+            TPM_application_task_start("lacpy");
+
+            invert_lacpy(A, L, akk, lkk, k, k);
 
-#pragma omp task depend(in : A[i * tile_size + i]) \
-    depend(inout : A[i * tile_size + j])
+            TPM_application_task_finish("lacpy");
+        }
+    }
+
+    // inv(U) in place, the tile rows above the diagonal tile k multiplied
+    // by the inverse of the tiles of step k
+    for (int k = 0; k < A.nt; k++)
+    {
+        double *akk = A(k, k);
+        int tempkn = tpm_tile_cols(A, k);
+
+        for (int n = k + 1; n < A.nt; n++)
+        {
+            double *akn = A(k, n);
+            int tempnn = tpm_tile_cols(A, n);
+
+#pragma omp task firstprivate(akk, akn, tempkn, tempnn) depend(in : akk[0 : tile_size * tile_size]) \
+    depend(inout : akn[0 : tile_size * tile_size])
             {
                 TPM_application_task_start("trsm");
 
-                cblas_dtrsm(CblasRowMajor, CblasLeft, CblasLower, CblasNoTrans, CblasUnit, tile_size,
-                            tile_size, 1.0, &A[i * matrix_size + i], lda, &A[i * matrix_size + j], lda);
+                cblas_dtrsm(CblasColMajor, CblasLeft, CblasUpper, CblasNoTrans, CblasNonUnit,
+                            tempkn, tempnn, -1.0, akk, A.tile_ld, akn, A.tile_ld);
 
                 TPM_application_task_finish("trsm");
             }
+        }
+
+        for (int n = k + 1; n < A.nt; n++)
+        {
+            double *akn = A(k, n);
+            int tempnn = tpm_tile_cols(A, n);
+            for (int m = 0; m < k; m++)
+            {
+                double *amk = A(m, k);
+                double *amn = A(m, n);
+                int tempmm = tpm_tile_rows(A, m);
+
+#pragma omp task firstprivate(akn, amk, amn, tempkn, tempnn, tempmm) \
+    depend(in : amk[0 : tile_size * tile_size], akn[0 : tile_size * tile_size]) \
+    depend(inout : amn[0 : tile_size * tile_size])
+                {
+                    TPM_application_task_start("gemm");
+
+                    cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans, tempmm, tempnn, tempkn,
+                                1.0, amk, A.tile_ld, akn, A.tile_ld, 1.0, amn, A.tile_ld);
+
+                    TPM_application_task_finish("gemm");
+                }
+            }
+        }
+
+        for (int m = 0; m < k; m++)
+        {
+            double *amk = A(m, k);
+            int tempmm = tpm_tile_rows(A, m);
 
-#pragma omp task depend(in : A[i * tile_size + i]) \
-    depend(inout : A[j * tile_size + i])
+#pragma omp task firstprivate(akk, amk, tempkn, tempmm) depend(in : akk[0 : tile_size * tile_size]) \
+    depend(inout : amk[0 : tile_size * tile_size])
             {
                 TPM_application_task_start("trsm");
 
-                cblas_dtrsm(CblasRowMajor, CblasRight, CblasUpper, CblasNoTrans, CblasNonUnit, tile_size,
-                            tile_size, 1.0, &A[i * matrix_size + i], lda, &A[j * matrix_size + i], lda);
+                cblas_dtrsm(CblasColMajor, CblasRight, CblasUpper, CblasNoTrans, CblasNonUnit,
+                            tempmm, tempkn, 1.0, akk, A.tile_ld, amk, A.tile_ld);
 
                 TPM_application_task_finish("trsm");
             }
         }
 
-        for (int j = i + tile_size; j < matrix_size; j += tile_size)
+#pragma omp task firstprivate(akk, tempkn) depend(inout : akk[0 : tile_size * tile_size])
+        {
+            TPM_application_task_start("trtri");
+
+            LAPACKE_dtrtri(LAPACK_COL_MAJOR, 'U', 'N', tempkn, akk, A.tile_ld);
+
+            TPM_application_task_finish("trtri");
+        }
+    }
+
+    // X L = inv(U), tile column by tile column from the last one, the tile
+    // rows independently of each other
+    for (int k = A.nt - 1; k >= 0; k--)
+    {
+        double *lkk = L(k, k);
+        int tempkn = tpm_tile_cols(A, k);
+        for (int m = 0; m < A.mt; m++)
         {
-            for (int k = i + tile_size; k < matrix_size; k += tile_size)
+            double *amk = A(m, k);
+            int tempmm = tpm_tile_rows(A, m);
+
+            for (int j = k + 1; j < A.nt; j++)
             {
+                double *amj = A(m, j);
+                double *ljk = L(j, k);
+                int tempjn = tpm_tile_cols(A, j);
 
-#pragma omp task                                        \
-depend(in : A[i * tile_size + j], A[k * tile_size + i]) \
-    depend(inout : A[k * tile_size + j])
+#pragma omp task firstprivate(amj, ljk, amk, tempkn, tempmm, tempjn) \
+    depend(in : amj[0 : tile_size * tile_size], ljk[0 : tile_size * tile_size]) \
+    depend(inout : amk[0 : tile_size * tile_size])
                 {
                     TPM_application_task_start("gemm");
 
-                    cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, tile_size, tile_size, tile_size,
-                                -1.0, &A[k * matrix_size + i], lda, &A[i * matrix_size + j], lda,
-                                1.0, &A[k * matrix_size + j], lda);
+                    cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans, tempmm, tempkn, tempjn,
+                                -1.0, amj, A.tile_ld, ljk, L.tile_ld, 1.0, amk, A.tile_ld);
 
                     TPM_application_task_finish("gemm");
                 }
             }
+
+#pragma omp task firstprivate(lkk, amk, tempkn, tempmm) depend(in : lkk[0 : tile_size * tile_size]) \
+    depend(inout : amk[0 : tile_size * tile_size])
+            {
+                TPM_application_task_start("trsm");
+
+                cblas_dtrsm(CblasColMajor, CblasRight, CblasLower, CblasNoTrans, CblasUnit,
+                            tempmm, tempkn, 1.0, lkk, L.tile_ld, amk, A.tile_ld);
+
+                TPM_application_task_finish("trsm");
+            }
         }
     }
 
-#pragma omp taskwait
-
-    for (int i = 0; i < matrix_size; i += tile_size)
+    // Column interchanges of P in reverse order, tile row by tile row. The
+    // first tile of a row is the last one solved for, after all the others
+    for (int m = 0; m < A.mt; m++)
     {
+        int tempmm = tpm_tile_rows(A, m);
 
-#pragma omp task depend(inout : A[i * tile_size + i])
+#pragma omp task firstprivate(m, tempmm) depend(inout : *(double *)A(m, 0))
         {
-            TPM_application_task_start("getri");
+            TPM_application_task_start("colswp");
 
-            LAPACKE_dgetri(LAPACK_ROW_MAJOR, tile_size, &A[i * matrix_size + i], lda, &ipiv[i]);
+            for (int i = A.n - 1; i >= 0; i--)
+            {
+                int p = ipiv[i] - 1;
+                if (p != i)
+                    cblas_dswap(tempmm, (double *)A(m, i / tile_size) + (size_t)(i % tile_size) * A.tile_ld, 1,
+                                (double *)A(m, p / tile_size) + (size_t)(p % tile_size) * A.tile_ld, 1);
+            }
 
-            TPM_application_task_finish("getri");
+            TPM_application_task_finish("colswp");
         }
     }
+
+    // The column elements and the workspace are only freed once no task can
+    // depend on them
+#pragma omp taskwait
+    free(column);
+    tpm_matrix_desc_free(&L);
 }
@@ -1,84 +1,99 @@
-void lu(int matrix_size, int tile_size, double *pA, int *ipiv, double *A)
+// Tasks of the factorization, without waiting for them. The column array has
+// one element per tile column, whose address stands for the whole column in
+// the dependences: the gemm tasks of a step only read it, so that they run in
+// parallel, and the next row swaps or panel of the column write it, after all
+// of them. When the tasks are done, the last ones to write the L factor of a
+// tile column k and its diagonal tile depend on the address of A(k, k), and
+// the ones writing a tile of U above the diagonal on the address of the tile
+void lu_tasks(tpm_desc A, int *ipiv, char *column)
 {
     double alpha = 1., neg = -1.;
-    for (int k = 0; k < matrix_size / tile_size; k++)
+    int tile_size = A.tile_size;
+    for (int k = 0; k < min(A.mt, A.nt); k++)
     {
-        int m = matrix_size - k * tile_size;
-        double *akk = A + k * tile_size * matrix_size + k * tile_size * tile_size;
+        int m = A.m - k * tile_size;
+        int tempkn = tpm_tile_cols(A, k);
+        double *akk = A(k, k);
 
-#pragma omp task firstprivate(akk, m) depend(inout : akk[0 : m * tile_size]) \
+#pragma omp task firstprivate(akk, m, tempkn) depend(inout : akk[0 : m * tile_size], column[k]) \
     depend(out : ipiv[k * tile_size : tile_size])
         {
             TPM_application_task_start("getrfpiv");
 
-            tpm_tile_to_matrix(A + k * tile_size * matrix_size + k * tile_size * tile_size,
-                               pA + k * tile_size * matrix_size + k * tile_size, m, tile_size,
-                               tile_size, matrix_size);
-            LAPACKE_dgetrf(LAPACK_COL_MAJOR, m, tile_size, pA + k * tile_size * matrix_size + k * tile_size,
-                           matrix_size, ipiv + k * tile_size);
+            tpm_getrf_panel(A, k, ipiv + k * tile_size, PANEL_THREADS);
             // Update the ipiv
-            for (int i = k * tile_size; i < k * tile_size + tile_size; i++)
+            for (int i = k * tile_size; i < k * tile_size + min(m, tempkn); i++)
             {
                 ipiv[i] += k * tile_size;
             }
-            tpm_matrix_to_tile(A + k * tile_size * matrix_size + k * tile_size * tile_size,
-                               pA + k * tile_size * matrix_size + k * tile_size, m, tile_size,
-                               tile_size, matrix_size);
 
             TPM_application_task_finish("getrfpiv");
         }
 
+        // Pivoting to the left, of the tile columns already factorized, once
+        // nothing reads their L factor anymore
+        for (int n = 0; n < k; n++)
+        {
+#pragma omp task firstprivate(m, tempkn, n) depend(in : ipiv[k * tile_size : tile_size]) \
+    depend(inout : *(double *)A(n, n))
+            {
+                TPM_application_task_start("geswp");
+
+                tpm_geswp(A, n, k * tile_size, k * tile_size + min(m, tempkn), ipiv);
+
+                TPM_application_task_finish("geswp");
+            }
+        }
+
         // Update trailing submatrix
-        for (int j = k + 1; j < matrix_size / tile_size; j++)
+        for (int j = k + 1; j < A.nt; j++)
         {
-            double *akj = A + j * tile_size * matrix_size + k * tile_size * tile_size;
+            double *akj = A(k, j);
+            int tempjn = tpm_tile_cols(A, j);
 
-#pragma omp task firstprivate(akk, akj, m) depend(in : akk[0 : m * tile_size]) \
-    depend(in : ipiv[k * tile_size : tile_size]) depend(inout : akj[0 : tile_size * tile_size])
+#pragma omp task firstprivate(akk, akj, m, tempkn, tempjn) depend(in : akk[0 : m * tile_size]) \
+    depend(in : ipiv[k * tile_size : tile_size]) depend(inout : akj[0 : tile_size * tile_size], column[j])
             {
                 TPM_application_task_start("trsmswp");
 
                 int k1 = k * tile_size;
-                int k2 = k * tile_size + tile_size;
-                tpm_geswp(A + j * tile_size * matrix_size, tile_size, k1, k2, ipiv);
+                int k2 = k * tile_size + min(m, tempkn);
+                tpm_geswp(A, j, k1, k2, ipiv);
 
-                cblas_dtrsm(CblasColMajor, CblasLeft, CblasLower, CblasNoTrans, CblasUnit, tile_size,
-                            tile_size, alpha, akk, tile_size, akj, tile_size);
+                cblas_dtrsm(CblasColMajor, CblasLeft, CblasLower, CblasNoTrans, CblasUnit,
+                            min(m, tempkn), tempjn, alpha, akk, A.tile_ld, akj, A.tile_ld);
 
                 TPM_application_task_finish("trsmswp");
             }
 
-#pragma omp task firstprivate(akk, akj, m) depend(in : akk[0 : m * tile_size]) \
-    depend(inout : akj[0 : tile_size * tile_size], ipiv[k * tile_size : tile_size])
+            for (int i = k + 1; i < A.mt; i++)
             {
-                for (int i = k + 1; i < matrix_size / tile_size; i++)
+                double *aik = A(i, k);
+                double *aij = A(i, j);
+                int tempim = tpm_tile_rows(A, i);
+
+#pragma omp task firstprivate(akk, akj, aik, aij, m, tempkn, tempjn, tempim) \
+    depend(in : akk[0 : m * tile_size], akj[0 : tile_size * tile_size], column[j]) \
+    depend(inout : aij[0 : tile_size * tile_size])
                 {
                     TPM_application_task_start("gemm");
 
-                    cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans, tile_size, tile_size,
-                                tile_size, neg,
-                                A + k * tile_size * matrix_size + i * tile_size * tile_size,
-                                tile_size, akj, tile_size, alpha,
-                                A + j * tile_size * matrix_size + i * tile_size * tile_size, tile_size);
+                    cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans, tempim, tempjn,
+                                tempkn, neg, aik, A.tile_ld, akj, A.tile_ld, alpha,
+                                aij, A.tile_ld);
 
                     TPM_application_task_finish("gemm");
                 }
             }
         }
     }
-    // Pivoting to the left
-    for (int t = 1; t < matrix_size / tile_size; t++)
-    {
-
-#pragma omp task                                                           \
-depend(in : ipiv[((matrix_size / tile_size) - 1) * tile_size : tile_size]) \
-    depend(inout : A[t * tile_size * matrix_size : matrix_size * tile_size])
-        {
-            TPM_application_task_start("geswp");
-
-            tpm_geswp(A + (t - 1) * tile_size * matrix_size, tile_size, t * tile_size, matrix_size, ipiv);
+}
 
-            TPM_application_task_finish("geswp");
-        }
-    }
-}
\ No newline at end of file
+void lu(tpm_desc A, int *ipiv)
+{
+    char *column = malloc(A.nt);
+    lu_tasks(A, ipiv, column);
+    // The column elements are only freed once no task can depend on them
+#pragma omp taskwait
+    free(column);
+}
@@ -1,80 +1,275 @@
+// Flat task graph: all the tasks created by the calling thread
 void qr(tpm_desc A, tpm_desc S)
 {
   int k = 0, m = 0, n = 0;
-  for (k = 0; k < A.matrix_size / A.tile_size; k++)
+  for (k = 0; k < min(A.mt, A.nt); k++)
   {
     double *tileA = A(k, k);
     double *tileS = S(k, k);
+    int tempkm = tpm_tile_rows(A, k);
+    int tempkn = tpm_tile_cols(A, k);
 
 #pragma omp task \
 depend(inout : tileA[0 : S.tile_size * S.tile_size]) depend(out : tileS[0 : A.tile_size * S.tile_size])
     {
       TPM_application_task_start("geqrt");
 
-      double tho[S.tile_size];
-      double work[S.tile_size * S.tile_size];
+      tpm_workspace *workspace = tpm_workspace_get();
 
-      tpm_dgeqrt(A.tile_size, S.tile_size, tileA, A.tile_size, tileS,
-                 S.tile_size, &tho[0], &work[0]);
+      tpm_dgeqrt(tempkm, tempkn, S.ib, tileA, A.tile_ld, tileS,
+                 S.tile_ld, workspace->tho, workspace->work);
+
+      TPM_application_task_finish("geqrt");
+    }
+
+    for (n = k + 1; n < A.nt; n++)
+    {
+      double *tileB = A(k, n);
+      int tempnn = tpm_tile_cols(A, n);
+
+#pragma omp task depend(in : tileA[0 : S.tile_size * S.tile_size], tileS[0 : A.tile_size * S.tile_size]) depend(inout : tileB[0 : S.tile_size * S.tile_size])
+      {
+        TPM_application_task_start("ormqr");
+
+        tpm_workspace *workspace = tpm_workspace_get();
+
+        tpm_dormqr(tpm_left, tpm_transpose, tempkm, tempnn,
+                   min(tempkm, tempkn), S.ib, tileA, A.tile_ld,
+                   tileS, S.tile_ld, tileB, A.tile_ld, workspace->work, tempnn);
+
+        TPM_application_task_finish("ormqr");
+      }
+    }
+
+    for (m = k + 1; m < A.mt; m++)
+    {
+      double *tileS = S(m, k);
+      double *tileB = A(m, k);
+      int tempmm = tpm_tile_rows(A, m);
+
+#pragma omp task depend(inout : tileA[0 : S.tile_size * S.tile_size], tileB[0 : S.tile_size * S.tile_size]) depend(out : tileS[0 : S.tile_size * A.tile_size])
+      {
+        TPM_application_task_start("tsqrt");
+
+        tpm_workspace *workspace = tpm_workspace_get();
+
+        tpm_dtsqrt(tempmm, tempkn, S.ib, tileA, A.tile_ld, tileB,
+                   A.tile_ld, tileS, S.tile_ld, workspace->tho, workspace->work);
+
+        TPM_application_task_finish("tsqrt");
+      }
+
+      for (n = k + 1; n < A.nt; n++)
+      {
+        double *tileA = A(k, n);
+        double *tileB = A(m, n);
+        double *tileC = A(m, k);
+        int tempnn = tpm_tile_cols(A, n);
+
+#pragma omp task depend(inout : tileA[0 : S.tile_size * S.tile_size], tileB[0 : S.tile_size * S.tile_size]) depend(in : tileC[0 : S.tile_size * S.tile_size], tileS[0 : A.tile_size * S.tile_size])
+        {
+          TPM_application_task_start("tsmqr");
+
+          tpm_workspace *workspace = tpm_workspace_get();
+
+          tpm_dtsmqr(tpm_left, tpm_transpose, A.tile_size, tempnn, tempmm,
+                     tempnn, tempkn, S.ib, tileA, A.tile_ld, tileB,
+                     A.tile_ld, tileC, A.tile_ld, tileS, S.tile_ld,
+                     workspace->work, S.ib);
+
+          TPM_application_task_finish("tsmqr");
+        }
+      }
+    }
+  }
+}
+
+// Binary tree reduction of the panels: every tile of the panel is factorized
+// by its own geqrt, then the triangles are merged by pairs with ttqrt, at
+// distances 1, 2, 4... so that a panel of p tiles takes log2(p) steps instead
+// of p. The factors of the ttqrt of the tile (m, k) are in S(A.mt + m, k),
+// under the ones of its geqrt
+void qr_tree(tpm_desc A, tpm_desc S)
+{
+  int k = 0, m = 0, n = 0;
+  for (k = 0; k < min(A.mt, A.nt); k++)
+  {
+    int tempkn = tpm_tile_cols(A, k);
+
+    for (m = k; m < A.mt; m++)
+    {
+      double *tileA = A(m, k);
+      double *tileS = S(m, k);
+      int tempmm = tpm_tile_rows(A, m);
+
+#pragma omp task firstprivate(tileA, tileS, tempmm) \
+depend(inout : tileA[0 : S.tile_size * S.tile_size]) depend(out : tileS[0 : A.tile_size * S.tile_size])
+      {
+        TPM_application_task_start("geqrt");
+
+        tpm_workspace *workspace = tpm_workspace_get();
+
+        tpm_dgeqrt(tempmm, tempkn, S.ib, tileA, A.tile_ld, tileS,
+                   S.tile_ld, workspace->tho, workspace->work);
+
+        TPM_application_task_finish("geqrt");
+      }
+
+      for (n = k + 1; n < A.nt; n++)
+      {
+        double *tileB = A(m, n);
+        int tempnn = tpm_tile_cols(A, n);
+
+#pragma omp task firstprivate(tileA, tileS, tileB, tempmm, tempnn) \
+depend(in : tileA[0 : S.tile_size * S.tile_size], tileS[0 : A.tile_size * S.tile_size]) depend(inout : tileB[0 : S.tile_size * S.tile_size])
+        {
+          TPM_application_task_start("ormqr");
+
+          tpm_workspace *workspace = tpm_workspace_get();
+
+          tpm_dormqr(tpm_left, tpm_transpose, tempmm, tempnn,
+                     min(tempmm, tempkn), S.ib, tileA, A.tile_ld,
+                     tileS, S.tile_ld, tileB, A.tile_ld, workspace->work, tempnn);
+
+          TPM_application_task_finish("ormqr");
+        }
+      }
+    }
+
+    // The triangle of the tile m + step is merged into the one of the tile
+    // m, which carries on to the next level
+    for (int step = 1; k + step < A.mt; step *= 2)
+    {
+      for (m = k; m + step < A.mt; m += 2 * step)
+      {
+        int p = m + step;
+        double *tileA = A(m, k);
+        double *tileB = A(p, k);
+        double *tileS = S(A.mt + p, k);
+        int tempmm = tpm_tile_rows(A, m);
+        int temppm = tpm_tile_rows(A, p);
+
+#pragma omp task firstprivate(tileA, tileB, tileS, temppm) \
+depend(inout : tileA[0 : S.tile_size * S.tile_size], tileB[0 : S.tile_size * S.tile_size]) depend(out : tileS[0 : S.tile_size * A.tile_size])
+        {
+          TPM_application_task_start("ttqrt");
+
+          tpm_workspace *workspace = tpm_workspace_get();
+
+          tpm_dttqrt(temppm, tempkn, S.ib, tileA, A.tile_ld, tileB,
+                     A.tile_ld, tileS, S.tile_ld, workspace->tho, workspace->work);
+
+          TPM_application_task_finish("ttqrt");
+        }
+
+        for (n = k + 1; n < A.nt; n++)
+        {
+          double *tileC = A(m, n);
+          double *tileD = A(p, n);
+          int tempnn = tpm_tile_cols(A, n);
+
+#pragma omp task firstprivate(tileB, tileC, tileD, tileS, tempmm, temppm, tempnn) \
+depend(inout : tileC[0 : S.tile_size * S.tile_size], tileD[0 : S.tile_size * S.tile_size]) depend(in : tileB[0 : S.tile_size * S.tile_size], tileS[0 : A.tile_size * S.tile_size])
+          {
+            TPM_application_task_start("ttmqr");
+
+            tpm_workspace *workspace = tpm_workspace_get();
+
+            tpm_dttmqr(tpm_left, tpm_transpose, tempmm, tempnn, temppm, tempnn,
+                       tempkn, S.ib, tileC, A.tile_ld, tileD, A.tile_ld,
+                       tileB, A.tile_ld, tileS, S.tile_ld, workspace->work,
+                       S.ib);
+
+            TPM_application_task_finish("ttmqr");
+          }
+        }
+      }
+    }
+  }
+}
+
+// Tasks of step k created from inside its geqrt task, with the same
+// unordered dependences as cholesky_nested
+void qr_nested(tpm_desc A, tpm_desc S)
+{
+  int k = 0, m = 0, n = 0;
+  for (k = 0; k < min(A.mt, A.nt); k++)
+  {
+    double *tileA = A(k, k);
+    double *tileS = S(k, k);
+    int tempkm = tpm_tile_rows(A, k);
+    int tempkn = tpm_tile_cols(A, k);
+
+#pragma omp task \
+depend(inout : tileA[0 : S.tile_size * S.tile_size]) depend(out : tileS[0 : A.tile_size * S.tile_size])
+    {
+      TPM_application_task_start("geqrt");
+
+      tpm_workspace *workspace = tpm_workspace_get();
+
+      tpm_dgeqrt(tempkm, tempkn, S.ib, tileA, A.tile_ld, tileS,
+                 S.tile_ld, workspace->tho, workspace->work);
 
       TPM_application_task_finish("geqrt");
 
-      for (n = k + 1; n < A.matrix_size / A.tile_size; n++)
+      for (n = k + 1; n < A.nt; n++)
       {
         double *tileA = A(k, k);
         double *tileS = S(k, k);
         double *tileB = A(k, n);
+        int tempnn = tpm_tile_cols(A, n);
 
 #pragma omp task depend(in : tileA[0 : S.tile_size * S.tile_size], tileS[0 : A.tile_size * S.tile_size]) depend(inout : tileB[0 : S.tile_size * S.tile_size])
         {
           TPM_application_task_start("ormqr");
 
-          double work[S.tile_size * S.tile_size];
+          tpm_workspace *workspace = tpm_workspace_get();
 
-          tpm_dormqr(tpm_left, tpm_transpose, A.tile_size, tileA, A.tile_size,
-                     tileS, S.tile_size, tileB, A.tile_size, &work[0],
-                     S.tile_size);
+          tpm_dormqr(tpm_left, tpm_transpose, tempkm, tempnn,
+                     min(tempkm, tempkn), S.ib, tileA, A.tile_ld,
+                     tileS, S.tile_ld, tileB, A.tile_ld, workspace->work, tempnn);
 
           TPM_application_task_finish("ormqr");
         }
       }
 
-      for (m = k + 1; m < A.matrix_size / A.tile_size; m++)
+      for (m = k + 1; m < A.mt; m++)
       {
         double *tileA = A(k, k);
         double *tileS = S(m, k);
         double *tileB = A(m, k);
+        int tempmm = tpm_tile_rows(A, m);
 
 #pragma omp task depend(inout : tileA[0 : S.tile_size * S.tile_size], tileB[0 : S.tile_size * S.tile_size]) depend(out : tileS[0 : S.tile_size * A.tile_size])
         {
           TPM_application_task_start("tsqrt");
 
-          double work[S.tile_size * S.tile_size];
-          double tho[S.tile_size];
+          tpm_workspace *workspace = tpm_workspace_get();
 
-          tpm_dtsqrt(A.tile_size, tileA, A.tile_size, tileB, A.tile_size, tileS,
-                     S.tile_size, &tho[0], &work[0]);
+          tpm_dtsqrt(tempmm, tempkn, S.ib, tileA, A.tile_ld, tileB,
+                     A.tile_ld, tileS, S.tile_ld, workspace->tho, workspace->work);
 
           TPM_application_task_finish("tsqrt");
         }
 
-        for (n = k + 1; n < A.matrix_size / A.tile_size; n++)
+        for (n = k + 1; n < A.nt; n++)
         {
           double *tileA = A(k, n);
           double *tileS = S(m, k);
           double *tileB = A(m, n);
           double *tileC = A(m, k);
+          int tempnn = tpm_tile_cols(A, n);
 
 #pragma omp task depend(inout : tileA[0 : S.tile_size * S.tile_size], tileB[0 : S.tile_size * S.tile_size]) depend(in : tileC[0 : S.tile_size * S.tile_size], tileS[0 : A.tile_size * S.tile_size])
           {
             TPM_application_task_start("tsmqr");
 
-            double work[S.tile_size * S.tile_size];
+            tpm_workspace *workspace = tpm_workspace_get();
 
-            tpm_dtsmqr(tpm_left, tpm_transpose, A.tile_size, A.tile_size,
-                       A.tile_size, A.tile_size, tileA, A.tile_size, tileB,
-                       A.tile_size, tileC, A.tile_size, tileS, S.tile_size,
-                       &work[0], A.tile_size);
+            tpm_dtsmqr(tpm_left, tpm_transpose, A.tile_size, tempnn, tempmm,
+                       tempnn, tempkn, S.ib, tileA, A.tile_ld, tileB,
+                       A.tile_ld, tileC, A.tile_ld, tileS, S.tile_ld,
+                       workspace->work, S.ib);
 
             TPM_application_task_finish("tsmqr");
           }
@@ -82,4 +277,4 @@ depend(inout : tileA[0 : S.tile_size * S.tile_size]) depend(out : tileS[0 : A.ti
       }
     }
   }
-}
\ No newline at end of file
+}
@@ -7,7 +7,7 @@
  *
  *        Version:  1.0
  *        Created:  15/05/2023
- *       Revision:  none
+ *       Revision:  19/10/2026
  *       Compiler:  clang
  *
  *         Author:  Idriss Daoudi <idaoudi@anl.gov>
@@ -16,7 +16,9 @@
  * =====================================================================================
  */
 
-void tpm_geswp(double *A, int tile_size, int k1, int k2, int *ipiv)
+// Row interchanges k1 to k2 - 1 of ipiv (one based, global rows) applied to
+// the tile column n
+void tpm_geswp(tpm_desc A, int n, int k1, int k2, int *ipiv)
 {
     int m, m1, m2;
     for (m = k1; m < k2; m++)
@@ -26,8 +28,8 @@ void tpm_geswp(double *A, int tile_size, int k1, int k2, int *ipiv)
             m1 = m;
             m2 = ipiv[m] - 1;
 
-            cblas_dswap(tile_size, A + (m1 / tile_size) * (tile_size * tile_size) + m1 % tile_size, tile_size,
-                        A + (m2 / tile_size) * (tile_size * tile_size) + m2 % tile_size, tile_size);
+            cblas_dswap(tpm_tile_cols(A, n), (double *)A(m1 / A.tile_size, n) + m1 % A.tile_size, A.tile_ld,
+                        (double *)A(m2 / A.tile_size, n) + m2 % A.tile_size, A.tile_ld);
         }
     }
-}
\ No newline at end of file
+}
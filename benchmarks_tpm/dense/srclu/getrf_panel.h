@@ -0,0 +1,142 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  getrf_panel.h
+ *
+ *    Description:  Multithreaded panel factorization in the tiles
+ *
+ *        Version:  1.0
+ *        Created:  19/10/2026
+ *       Revision:  none
+ *       Compiler:  clang
+ *
+ *         Author:  Idriss Daoudi <idaoudi@anl.gov>
+ *   Organization:  Argonne National Laboratory
+ *
+ * =====================================================================================
+ */
+
+// Columns factorized one at a time before the update of the rest of the panel
+#define TPM_PANEL_IB 32
+
+// Row g of the panel of tile column k, counted from its first row
+static inline double *tpm_panel_row(tpm_desc A, int k, int g)
+{
+    return (double *)A(k + g / A.tile_size, k) + g % A.tile_size;
+}
+
+// Rows of the panel tile t owned by the thread rank, from row first on, as
+// an offset and a count (0 if none)
+static inline int tpm_panel_rows(tpm_desc A, int k, int t, int first, int *offset)
+{
+    int rows = tpm_tile_rows(A, k + t);
+    *offset = max(first - t * A.tile_size, 0);
+    return max(rows - *offset, 0);
+}
+
+// LU factorization with partial pivoting of the tile column k, from the tile
+// row k down, in place in the tiles: a blocked right looking factorization of
+// TPM_PANEL_IB columns at a time, the row interchanges applied to the whole
+// panel. The threads of a nested team share the tiles of the panel, one out
+// of the team size each, and meet at a barrier around each pivot choice. The
+// interchanges are stored in ipiv as by LAPACKE_dgetrf, relative to the
+// first row of the panel
+void tpm_getrf_panel(tpm_desc A, int k, int *ipiv, int threads)
+{
+    int tiles = A.mt - k;
+    int n = tpm_tile_cols(A, k);
+    int mn = min(A.m - k * A.tile_size, n);
+    threads = max(min(threads, tiles), 1);
+    double max_val[threads];
+    int max_idx[threads];
+
+#pragma omp parallel num_threads(threads)
+    {
+        int rank = omp_get_thread_num();
+        int size = omp_get_num_threads();
+        double *diagonal = A(k, k);
+
+        for (int k0 = 0; k0 < mn; k0 += TPM_PANEL_IB)
+        {
+            int kb = min(mn - k0, TPM_PANEL_IB);
+            for (int j = k0; j < k0 + kb; j++)
+            {
+                // Largest element of column j in the rows of this thread,
+                // the first one on ties as idamax
+                max_val[rank] = -1.0;
+                max_idx[rank] = j;
+                for (int t = rank; t < tiles; t += size)
+                {
+                    int offset, rows = tpm_panel_rows(A, k, t, j, &offset);
+                    if (rows == 0)
+                        continue;
+                    double *column = (double *)A(k + t, k) + (size_t)j * A.tile_ld + offset;
+                    int i = cblas_idamax(rows, column, 1);
+                    if (fabs(column[i]) > max_val[rank])
+                    {
+                        max_val[rank] = fabs(column[i]);
+                        max_idx[rank] = t * A.tile_size + offset + i;
+                    }
+                }
+#pragma omp barrier
+                int pivot = max_idx[0];
+                double value = max_val[0];
+                for (int r = 1; r < size; r++)
+                {
+                    if (max_val[r] > value || (max_val[r] == value && max_idx[r] < pivot))
+                    {
+                        value = max_val[r];
+                        pivot = max_idx[r];
+                    }
+                }
+                if (rank == 0)
+                {
+                    ipiv[j] = pivot + 1;
+                    if (pivot != j)
+                        cblas_dswap(n, tpm_panel_row(A, k, j), A.tile_ld,
+                                    tpm_panel_row(A, k, pivot), A.tile_ld);
+                }
+#pragma omp barrier
+                // Scaling of the column and update of the rest of the block,
+                // in the rows of this thread, a singular column left as is
+                double pivot_value = diagonal[(size_t)j * A.tile_ld + j];
+                if (pivot_value == 0.0)
+                    continue;
+                for (int t = rank; t < tiles; t += size)
+                {
+                    int offset, rows = tpm_panel_rows(A, k, t, j + 1, &offset);
+                    if (rows == 0)
+                        continue;
+                    double *tile = (double *)A(k + t, k) + offset;
+                    cblas_dscal(rows, 1.0 / pivot_value, tile + (size_t)j * A.tile_ld, 1);
+                    cblas_dger(CblasColMajor, rows, k0 + kb - j - 1, -1.0,
+                               tile + (size_t)j * A.tile_ld, 1,
+                               diagonal + (size_t)(j + 1) * A.tile_ld + j, A.tile_ld,
+                               tile + (size_t)(j + 1) * A.tile_ld, A.tile_ld);
+                }
+            }
+
+            // Update of the columns right of the block, with its rows of U
+            // first, which are in the diagonal tile
+            int right = k0 + kb;
+            if (right >= n)
+                continue;
+            if (rank == 0)
+                cblas_dtrsm(CblasColMajor, CblasLeft, CblasLower, CblasNoTrans, CblasUnit,
+                            kb, n - right, 1.0, diagonal + (size_t)k0 * A.tile_ld + k0, A.tile_ld,
+                            diagonal + (size_t)right * A.tile_ld + k0, A.tile_ld);
+#pragma omp barrier
+            for (int t = rank; t < tiles; t += size)
+            {
+                int offset, rows = tpm_panel_rows(A, k, t, right, &offset);
+                if (rows == 0)
+                    continue;
+                double *tile = (double *)A(k + t, k) + offset;
+                cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans, rows, n - right, kb,
+                            -1.0, tile + (size_t)k0 * A.tile_ld, A.tile_ld,
+                            diagonal + (size_t)right * A.tile_ld + k0, A.tile_ld, 1.0,
+                            tile + (size_t)right * A.tile_ld, A.tile_ld);
+            }
+        }
+    }
+}
@@ -7,7 +7,7 @@
  *
  *        Version:  1.0
  *        Created:  15/05/2023
- *       Revision:  none
+ *       Revision:  19/10/2026
  *       Compiler:  clang
  *
  *         Author:  Idriss Daoudi <idaoudi@anl.gov>
@@ -16,26 +16,13 @@
  * =====================================================================================
  */
 
-void tpm_lacpy(char flag, double *source, double *dest, int matrix_size, int tile_size)
+// Copy of a rows x cols block between two column major storages
+void tpm_lacpy(const double *source, int lds, double *dest, int ldd, int rows, int cols)
 {
-    // Transpose
-    if (flag == 't')
+    for (int i = 0; i < cols; i++)
     {
-        for (int i = 0; i < tile_size; i++)
-        {
-            memcpy(dest, source, sizeof(double) * tile_size);
-            source += matrix_size;
-            dest += tile_size;
-        }
+        memcpy(dest, source, sizeof(double) * rows);
+        source += lds;
+        dest += ldd;
     }
-    // Column
-    else if (flag == 'c')
-    {
-        for (int i = 0; i < tile_size; i++)
-        {
-            memcpy(dest, source, sizeof(double) * tile_size);
-            source += tile_size;
-            dest += matrix_size;
-        }
-    }
-}
\ No newline at end of file
+}
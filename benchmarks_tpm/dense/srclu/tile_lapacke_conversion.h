@@ -8,7 +8,7 @@
  *
  *        Version:  1.0
  *        Created:  15/05/2023
- *       Revision:  none
+ *       Revision:  19/10/2026
  *       Compiler:  clang
  *
  *         Author:  Idriss Daoudi <idaoudi@anl.gov>
@@ -17,38 +17,28 @@
  * =====================================================================================
  */
 
-void tpm_matrix_to_tile(double *A, double *pA, int M, int N, int tile_size, int LDA)
+// The tiles m to mt - 1 of the tile columns n to nt - 1, to or from the
+// LAPACKE layout matrix pA whose element (0, 0) is the first one of tile (m, n)
+void tpm_matrix_to_tile(tpm_desc A, int m, int n, int mt, int nt, double *pA, int LDA)
 {
-    int mt = M / tile_size, nt = N / tile_size;
-    int n, m;
-    double *tptr;
-    double *cptr;
-    for (n = 0; n < nt; n++)
+    for (int j = n; j < nt; j++)
     {
-        for (m = 0; m < mt; m++)
+        for (int i = m; i < mt; i++)
         {
-
-            tptr = A + n * tile_size * LDA + m * tile_size * tile_size;
-            cptr = pA + n * tile_size * LDA + m * tile_size;
-            tpm_lacpy('t', cptr, tptr, LDA, tile_size);
+            double *cptr = pA + (size_t)(j - n) * A.tile_size * LDA + (i - m) * A.tile_size;
+            tpm_lacpy(cptr, LDA, A(i, j), A.tile_ld, tpm_tile_rows(A, i), tpm_tile_cols(A, j));
         }
     }
 }
 
-void tpm_tile_to_matrix(double *A, double *pA, int M, int N, int tile_size, int LDA)
+void tpm_tile_to_matrix(tpm_desc A, int m, int n, int mt, int nt, double *pA, int LDA)
 {
-    int mt = M / tile_size, nt = N / tile_size;
-    int n, m;
-    double *tptr;
-    double *cptr;
-    for (n = 0; n < nt; n++)
+    for (int j = n; j < nt; j++)
     {
-        for (m = 0; m < mt; m++)
+        for (int i = m; i < mt; i++)
         {
-
-            tptr = A + n * tile_size * LDA + m * tile_size * tile_size;
-            cptr = pA + n * tile_size * LDA + m * tile_size;
-            tpm_lacpy('c', tptr, cptr, LDA, tile_size);
+            double *cptr = pA + (size_t)(j - n) * A.tile_size * LDA + (i - m) * A.tile_size;
+            tpm_lacpy(A(i, j), A.tile_ld, cptr, LDA, tpm_tile_rows(A, i), tpm_tile_cols(A, j));
         }
     }
-}
\ No newline at end of file
+}
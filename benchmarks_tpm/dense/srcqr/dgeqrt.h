@@ -7,7 +7,7 @@
  *
  *        Version:  1.0
  *        Created:  25/12/2022
- *       Revision:  19/03/2023
+ *       Revision:  19/10/2026
  *       Compiler:  clang
  *
  *         Author:  Idriss Daoudi <idaoudi@anl.gov>
@@ -16,28 +16,30 @@
  * =====================================================================================
  */
 
-int tpm_dgeqrt(int tileA_size, int Stile_size, double *tileA, int lda,
-               double *tileS, int lds, double *tho, double *workspace)
+// QR factorization of an M x N tile, by blocks of IB columns. The
+// reflectors overwrite the tile below the diagonal, and their IB x N block
+// triangular factors go to tileS
+int tpm_dgeqrt(int M, int N, int IB, double *tileA, int lda, double *tileS,
+               int lds, double *tho, double *workspace)
 {
   int gamma;
-  if (tileA_size == 0 || Stile_size == 0)
+  if (M == 0 || N == 0 || IB == 0)
     return 0;
-  int k = tileA_size;
-  for (int i = 0; i < k; i += Stile_size)
+  int k = min(M, N);
+  for (int i = 0; i < k; i += IB)
   {
-    gamma = min(Stile_size, k - i);
-    LAPACKE_dgeqr2_work(LAPACK_COL_MAJOR, tileA_size - i, gamma,
-                        &tileA[lda * i + i], lda, &tho[i], workspace);
-    LAPACKE_dlarft_work(LAPACK_COL_MAJOR, 'F', 'C', tileA_size - i, gamma,
+    gamma = min(IB, k - i);
+    LAPACKE_dgeqr2_work(LAPACK_COL_MAJOR, M - i, gamma, &tileA[lda * i + i],
+                        lda, &tho[i], workspace);
+    LAPACKE_dlarft_work(LAPACK_COL_MAJOR, 'F', 'C', M - i, gamma,
                         &tileA[lda * i + i], lda, &tho[i], &tileS[lds * i],
                         lds);
-    if (tileA_size > i + gamma)
+    if (N > i + gamma)
     {
-      LAPACKE_dlarfb_work(LAPACK_COL_MAJOR, 'L', 'T', 'F', 'C', tileA_size - i,
-                          tileA_size - i - gamma, gamma, &tileA[lda * i + i],
-                          lda, &tileS[lds * i], lds,
-                          &tileA[lda * (i + gamma) + i], lda, workspace,
-                          tileA_size - i - gamma);
+      LAPACKE_dlarfb_work(LAPACK_COL_MAJOR, 'L', 'T', 'F', 'C', M - i,
+                          N - i - gamma, gamma, &tileA[lda * i + i], lda,
+                          &tileS[lds * i], lds, &tileA[lda * (i + gamma) + i],
+                          lda, workspace, N - i - gamma);
     }
   }
   return 0;
@@ -7,7 +7,7 @@
  *
  *        Version:  1.0
  *        Created:  25/12/2022
- *       Revision:  19/03/2023
+ *       Revision:  19/10/2026
  *       Compiler:  clang
  *
  *         Author:  Idriss Daoudi <idaoudi@anl.gov>
@@ -16,15 +16,16 @@
  * =====================================================================================
  */
 
-int tpm_dormqr(int side, int transpose, int tileA_size, const double *tileA,
-               int lda, const double *tileS, int lds, double *tileB, int ldb,
-               double *workspace, int ldw)
+// Apply the K reflectors of a tpm_dgeqrt tile, by blocks of IB, to the
+// M x N tile B
+int tpm_dormqr(int side, int transpose, int M, int N, int K, int IB,
+               const double *tileA, int lda, const double *tileS, int lds,
+               double *tileB, int ldb, double *workspace, int ldw)
 {
   int gamma, i1, i3;
-  int aindex = tileA_size;
-  int cindex = 0;
+  int mi = M, ni = N, ic = 0, jc = 0;
 
-  if (tileA_size == 0)
+  if (M == 0 || N == 0 || K == 0 || IB == 0)
   {
     return 0;
   }
@@ -32,21 +33,30 @@ int tpm_dormqr(int side, int transpose, int tileA_size, const double *tileA,
       (side == tpm_right && transpose == tpm_notranspose))
   {
     i1 = 0;
-    i3 = tileA_size;
+    i3 = IB;
   }
   else
   {
-    i1 = tileA_size - 1;
-    i3 = -tileA_size;
+    i1 = ((K - 1) / IB) * IB;
+    i3 = -IB;
   }
-  for (int i = i1; i > -1 && i < tileA_size; i += i3)
+  for (int i = i1; i > -1 && i < K; i += i3)
   {
-    gamma = min(tileA_size, tileA_size - i);
-    aindex = tileA_size - i;
-    cindex = i;
-    LAPACKE_dlarfb_work(LAPACK_COL_MAJOR, 'L', 'T', 'F', 'C', aindex, aindex,
-                        gamma, &tileA[lda * i + i], lda, &tileS[lds * i], lds,
-                        &tileB[ldb * cindex + cindex], ldb, workspace, ldw);
+    gamma = min(IB, K - i);
+    if (side == tpm_left)
+    {
+      mi = M - i;
+      ic = i;
+    }
+    else
+    {
+      ni = N - i;
+      jc = i;
+    }
+    LAPACKE_dlarfb_work(LAPACK_COL_MAJOR, side == tpm_left ? 'L' : 'R',
+                        transpose == tpm_transpose ? 'T' : 'N', 'F', 'C', mi,
+                        ni, gamma, &tileA[lda * i + i], lda, &tileS[lds * i],
+                        lds, &tileB[ldb * jc + ic], ldb, workspace, ldw);
   }
   return 0;
 }
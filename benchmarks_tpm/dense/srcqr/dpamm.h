@@ -37,9 +37,8 @@ static inline int tpm_dpamm_W(int side, int transpose, int upper_lower, int M,
                      workspace, ldw);
       if (L > 0)
       {
-        cblas_dtrmm(CblasColMajor, CblasLeft, /* Left */
-                    side, transpose, CblasNonUnit, L, N, 1.0, &tileS[v2], lds,
-                    workspace, ldw);
+        cblas_dtrmm(CblasColMajor, CblasLeft, upper_lower, transpose,
+                    CblasNonUnit, L, N, 1.0, &tileS[v2], lds, workspace, ldw);
         if (K > L)
         {
           cblas_dgemm(CblasColMajor, transpose, CblasNoTrans, L, N, K - L, 1.0,
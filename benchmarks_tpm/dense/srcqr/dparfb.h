@@ -20,40 +20,42 @@
 
 #include "dpamm.h"
 
-int tpm_dparfb(int side, int transpose, int direct, int store_column_row, int M,
-               int N, int K, int L, double *tileA1, int lda1, double *tileA2,
-               int lda2, const double *tileS, int lds, const double *tileB,
-               int ldb, double *workspace, int ldw)
+// Apply a block of K reflectors to the M1 x N1 tile A1 stacked on the
+// M2 x N2 tile A2, with L rows of the reflectors triangular
+int tpm_dparfb(int side, int transpose, int direct, int store_column_row,
+               int M1, int N1, int M2, int N2, int K, int L, double *tileA1,
+               int lda1, double *tileA2, int lda2, const double *tileS, int lds,
+               const double *tileB, int ldb, double *workspace, int ldw)
 {
-  if (M == 0 || N == 0 || K == 0)
+  if (M1 == 0 || N1 == 0 || M2 == 0 || N2 == 0 || K == 0)
     return 0;
 
   if (direct == tpm_forward)
   {
     if (side == tpm_left)
     {
-      tpm_dpamm(tpm_W, tpm_left, store_column_row, K, M, N, L, tileA1, lda1,
+      tpm_dpamm(tpm_W, tpm_left, store_column_row, K, N1, M2, L, tileA1, lda1,
                 tileA2, lda2, tileS, lds, workspace, ldw);
       cblas_dtrmm(CblasColMajor, CblasLeft, CblasUpper, transpose, CblasNonUnit,
-                  K, N, 1.0, tileB, ldb, workspace, ldw);
-      for (int j = 0; j < M; j++)
+                  K, N2, 1.0, tileB, ldb, workspace, ldw);
+      for (int j = 0; j < N1; j++)
       {
         cblas_daxpy(K, -1.0, &workspace[ldw * j], 1, &tileA1[lda1 * j], 1);
       }
-      tpm_dpamm(tpm_A2, tpm_left, store_column_row, N, N, K, L, tileA1, lda1,
+      tpm_dpamm(tpm_A2, tpm_left, store_column_row, M2, N2, K, L, tileA1, lda1,
                 tileA2, lda2, tileS, lds, workspace, ldw);
     }
     else
     {
-      tpm_dpamm(tpm_W, tpm_right, store_column_row, M, K, N, L, tileA1, lda1,
+      tpm_dpamm(tpm_W, tpm_right, store_column_row, M1, K, N2, L, tileA1, lda1,
                 tileA2, lda2, tileS, lds, workspace, ldw);
       cblas_dtrmm(CblasColMajor, CblasRight, CblasUpper, transpose,
-                  CblasNonUnit, N, K, 1.0, tileB, ldb, workspace, ldw);
+                  CblasNonUnit, M2, K, 1.0, tileB, ldb, workspace, ldw);
       for (int j = 0; j < K; j++)
       {
-        cblas_daxpy(M, -1.0, &workspace[ldw * j], 1, &tileA1[lda1 * j], 1);
+        cblas_daxpy(M1, -1.0, &workspace[ldw * j], 1, &tileA1[lda1 * j], 1);
       }
-      tpm_dpamm(tpm_A2, tpm_right, store_column_row, N, N, K, L, tileA1, lda1,
+      tpm_dpamm(tpm_A2, tpm_right, store_column_row, M2, N2, K, L, tileA1, lda1,
                 tileA2, lda2, tileS, lds, workspace, ldw);
     }
   }
@@ -7,7 +7,7 @@
  *
  *        Version:  1.0
  *        Created:  25/12/2022
- *       Revision:  19/03/2023
+ *       Revision:  19/10/2026
  *       Compiler:  clang
  *
  *         Author:  Idriss Daoudi <idaoudi@anl.gov>
@@ -18,39 +18,46 @@
 
 #include "dparfb.h"
 
-int tpm_dtsmqr(int side, int transpose, int M, int N, int K, int B,
-               double *tileA1, int lda1, double *tileA2, int lda2,
+// Apply the K reflectors of a tpm_dtsqrt (V, with factors tileB), by blocks
+// of IB, to the M1 x N1 tile A1 stacked on the M2 x N2 tile A2
+int tpm_dtsmqr(int side, int transpose, int M1, int N1, int M2, int N2, int K,
+               int IB, double *tileA1, int lda1, double *tileA2, int lda2,
                const double *tileS, int lds, const double *tileB, int ldb,
                double *workspace, int ldw)
 {
-  if (M == 0 || N == 0 || K == 0 || B == 0)
+  if (M1 == 0 || N1 == 0 || M2 == 0 || N2 == 0 || K == 0 || IB == 0)
     return 0;
 
   int i1, i3, gamma;
-  int ic = 0;
-  int m = M;
+  int ic = 0, jc = 0;
+  int mi = M1, ni = N1;
   if ((side == tpm_left && transpose != tpm_notranspose) ||
       (side == tpm_right && transpose == tpm_notranspose))
   {
     i1 = 0;
-    i3 = B;
+    i3 = IB;
   }
   else
   {
-    i1 = K - 1;
-    i3 = -B;
+    i1 = ((K - 1) / IB) * IB;
+    i3 = -IB;
   }
 
   for (int i = i1; i > -1 && i < K; i += i3)
   {
-    gamma = min(B, K - i);
+    gamma = min(IB, K - i);
     if (side == tpm_left)
     {
-      m = M - i;
+      mi = M1 - i;
       ic = i;
     }
-    tpm_dparfb(side, transpose, tpm_forward, tpm_column, m, N, gamma, 0,
-               &tileA1[lda1 * ic + ic], lda1, tileA2, lda2, &tileS[lds * i],
+    else
+    {
+      ni = N1 - i;
+      jc = i;
+    }
+    tpm_dparfb(side, transpose, tpm_forward, tpm_column, mi, ni, M2, N2, gamma,
+               0, &tileA1[lda1 * jc + ic], lda1, tileA2, lda2, &tileS[lds * i],
                lds, &tileB[ldb * i], ldb, workspace, ldw);
   }
   return 0;
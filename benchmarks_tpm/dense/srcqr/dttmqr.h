@@ -0,0 +1,67 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  dttmqr.h
+ *
+ *    Description:  DTTMQR implementation
+ *
+ *        Version:  1.0
+ *        Created:  19/10/2026
+ *       Revision:  none
+ *       Compiler:  clang
+ *
+ *         Author:  Idriss Daoudi <idaoudi@anl.gov>
+ *   Organization:  Argonne National Laboratory
+ *
+ * =====================================================================================
+ */
+
+// Apply the K reflectors of a tpm_dttqrt (V upper triangular, with factors
+// tileB), by blocks of IB, to the M1 x N1 tile A1 stacked on the M2 x N2
+// tile A2. Only the first rows of A2 a block of reflectors reaches change
+int tpm_dttmqr(int side, int transpose, int M1, int N1, int M2, int N2, int K,
+               int IB, double *tileA1, int lda1, double *tileA2, int lda2,
+               const double *tileS, int lds, const double *tileB, int ldb,
+               double *workspace, int ldw)
+{
+  if (M1 == 0 || N1 == 0 || M2 == 0 || N2 == 0 || K == 0 || IB == 0)
+    return 0;
+
+  int i1, i3, gamma, l;
+  int ic = 0, jc = 0;
+  int mi1 = M1, ni1 = N1, mi2 = M2, ni2 = N2;
+  if ((side == tpm_left && transpose != tpm_notranspose) ||
+      (side == tpm_right && transpose == tpm_notranspose))
+  {
+    i1 = 0;
+    i3 = IB;
+  }
+  else
+  {
+    i1 = ((K - 1) / IB) * IB;
+    i3 = -IB;
+  }
+
+  for (int i = i1; i > -1 && i < K; i += i3)
+  {
+    gamma = min(IB, K - i);
+    if (side == tpm_left)
+    {
+      mi1 = gamma;
+      mi2 = min(i + gamma, M2);
+      l = min(gamma, max(0, M2 - i));
+      ic = i;
+    }
+    else
+    {
+      ni1 = gamma;
+      ni2 = min(i + gamma, N2);
+      l = min(gamma, max(0, N2 - i));
+      jc = i;
+    }
+    tpm_dparfb(side, transpose, tpm_forward, tpm_column, mi1, ni1, mi2, ni2,
+               gamma, l, &tileA1[lda1 * jc + ic], lda1, tileA2, lda2,
+               &tileS[lds * i], lds, &tileB[ldb * i], ldb, workspace, ldw);
+  }
+  return 0;
+}
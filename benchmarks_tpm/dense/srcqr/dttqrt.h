@@ -0,0 +1,77 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  dttqrt.h
+ *
+ *    Description:  DTTQRT implementation
+ *
+ *        Version:  1.0
+ *        Created:  19/10/2026
+ *       Revision:  none
+ *       Compiler:  clang
+ *
+ *         Author:  Idriss Daoudi <idaoudi@anl.gov>
+ *   Organization:  Argonne National Laboratory
+ *
+ * =====================================================================================
+ */
+#include <cblas.h>
+
+// QR factorization of the N x N upper triangular tile A1 stacked on the
+// M x N upper triangular (trapezoidal if M < N) tile A2, by blocks of IB
+// columns. The reflectors overwrite the upper triangle of A2 only, whose
+// strictly lower part, the reflectors of its own tpm_dgeqrt, is kept
+int tpm_dttqrt(int M, int N, int IB, double *tileA1, int lda1, double *tileA2,
+               int lda2, double *tileS, int lds, double *tho,
+               double *workspace)
+{
+  double alpha;
+  int lambda, gamma, j, mi, ni, l;
+  if (M == 0 || N == 0 || IB == 0)
+    return 0;
+
+  for (lambda = 0; lambda < N; lambda += IB)
+  {
+    gamma = min(N - lambda, IB);
+    for (int i = 0; i < gamma; i++)
+    {
+      j = lambda + i;
+      mi = min(j + 1, M);
+      ni = gamma - i - 1;
+      LAPACKE_dlarfg_work(mi + 1, &tileA1[lda1 * j + j], &tileA2[lda2 * j], 1,
+                          &tho[j]);
+      if (ni > 0)
+      {
+        alpha = -tho[j];
+        cblas_dcopy(ni, &tileA1[lda1 * (j + 1) + j], lda1, workspace, 1);
+        cblas_dgemv(CblasColMajor, CblasTrans, mi, ni, 1.0,
+                    &tileA2[lda2 * (j + 1)], lda2, &tileA2[lda2 * j], 1, 1.0,
+                    workspace, 1);
+        cblas_daxpy(ni, alpha, workspace, 1, &tileA1[lda1 * (j + 1) + j],
+                    lda1);
+        cblas_dger(CblasColMajor, mi, ni, alpha, &tileA2[lda2 * j], 1,
+                   workspace, 1, &tileA2[lda2 * (j + 1)], lda2);
+      }
+      // The reflectors of the block before this one stop at their diagonal
+      for (int c = lambda; c < j; c++)
+        tileS[lds * j + c - lambda] =
+            -tho[j] * cblas_ddot(min(c + 1, M), &tileA2[lda2 * c], 1,
+                                 &tileA2[lda2 * j], 1);
+      cblas_dtrmv(CblasColMajor, CblasUpper, CblasNoTrans, CblasNonUnit, i,
+                  &tileS[lds * lambda], lds, &tileS[lds * j], 1);
+      tileS[lds * j + i] = tho[j];
+    }
+    if (N > lambda + gamma)
+    {
+      mi = min(lambda + gamma, M);
+      ni = N - (lambda + gamma);
+      l = min(gamma, max(0, mi - lambda));
+      tpm_dparfb(tpm_left, tpm_transpose, tpm_forward, tpm_column, gamma, ni,
+                 mi, ni, gamma, l, &tileA1[lda1 * (lambda + gamma) + lambda],
+                 lda1, &tileA2[lda2 * (lambda + gamma)], lda2,
+                 &tileA2[lda2 * lambda], lda2, &tileS[lds * lambda], lds,
+                 workspace, gamma);
+    }
+  }
+  return 0;
+}
@@ -1,52 +1,93 @@
+// Space of the gesvd and geev of the n x n problems, as queried from LAPACK
+size_t sylsvd_lwork(int n)
+{
+    double gesvd = 0.0, geev = 0.0;
+    LAPACKE_dgesvd_work(LAPACK_COL_MAJOR, 'A', 'A', n, n, NULL, n, NULL, NULL, n, NULL, n, &gesvd, -1);
+    LAPACKE_dgeev_work(LAPACK_COL_MAJOR, 'N', 'V', n, NULL, n, NULL, NULL, NULL, n, NULL, n, &geev, -1);
+    return (size_t)max(gesvd, geev);
+}
+
+// LAPACK space of a thread: the eigenvectors of geev, the imaginary parts of
+// the eigenvalues and the space of the routines. The copy of X the routines
+// overwrite goes to the work tile
+size_t sylsvd_workspace_size(int n)
+{
+    return (size_t)n * n + n + sylsvd_lwork(n);
+}
+
+// Per problem, the Sylvester equation A X + X B = C solved in place of C in
+// X, the SVD and the eigen decomposition of X, and the product of its
+// singular vectors. The matrices are column major, so that LAPACKE calls the
+// routines on them directly, without transposed copies. gesvd and geev only
+// read X, which they overwrite in a copy in the workspace of the thread, so
+// that they run concurrently. Each task handles a batch of consecutive
+// problems, and depends on the data of the first one, standing for the batch
 void sylsvd(double *As[], double *Bs[], double *Xs[], double *Us[], double *Ss[], double *VTs[],
-            double *EVs[], double *Ms[], int matrix_size, int iter)
+            double *EVs[], double *Ms[], int matrix_size, int iter, int batch)
 {
-    int info;
-    for (int i = 0; i < iter; i++)
+    int n = matrix_size;
+    int lwork = (int)sylsvd_lwork(n);
+    for (int first = 0; first < iter; first += batch)
     {
+        int last = min(first + batch, iter);
 
-#pragma omp task depend(in : Xs[i]) depend(out : Xs[i])
+#pragma omp task firstprivate(first, last) depend(inout : Xs[first][0 : n * n])
         {
             TPM_application_task_start("trsyl");
 
-            double scale;
-            info = LAPACKE_dtrsyl(LAPACK_ROW_MAJOR, 'N', 'N', 1, matrix_size, matrix_size, As[i], matrix_size, Bs[i], matrix_size, Xs[i], matrix_size, &scale);
+            for (int i = first; i < last; i++)
+            {
+                double scale;
+                LAPACKE_dtrsyl_work(LAPACK_COL_MAJOR, 'N', 'N', 1, n, n, As[i], n, Bs[i], n, Xs[i], n, &scale);
+            }
 
             TPM_application_task_finish("trsyl");
         }
 
-#pragma omp task depend(in : Xs[i]) depend(out : Us[i], Ss[i], VTs[i])
+#pragma omp task firstprivate(first, last) depend(in : Xs[first][0 : n * n]) \
+    depend(out : Us[first][0 : n * n], Ss[first][0 : n], VTs[first][0 : n * n])
         {
             TPM_application_task_start("gesvd");
 
-            double *superb = (double *)malloc((matrix_size - 1) * sizeof(double));
-            info = LAPACKE_dgesvd(LAPACK_ROW_MAJOR, 'A', 'A', matrix_size, matrix_size, Xs[i], matrix_size, Ss[i], Us[i], matrix_size, VTs[i], matrix_size, superb);
-            free(superb);
+            tpm_workspace *workspace = tpm_workspace_get();
+            for (int i = first; i < last; i++)
+            {
+                memcpy(workspace->work, Xs[i], (size_t)n * n * sizeof(double));
+                LAPACKE_dgesvd_work(LAPACK_COL_MAJOR, 'A', 'A', n, n, workspace->work, n, Ss[i], Us[i], n,
+                                    VTs[i], n, workspace->lapack + (size_t)n * n + n, lwork);
+            }
 
             TPM_application_task_finish("gesvd");
         }
 
-#pragma omp task depend(in : Xs[i]) depend(out : EVs[i])
+#pragma omp task firstprivate(first, last) depend(in : Xs[first][0 : n * n]) depend(out : EVs[first][0 : n])
         {
             TPM_application_task_start("geev");
 
-            double *EVI = (double *)malloc(matrix_size * sizeof(double)); // Imaginary part of the eigenvalues
-            int info = LAPACKE_dgeev(LAPACK_ROW_MAJOR, 'N', 'V', matrix_size, Xs[i], matrix_size, EVs[i], EVI, NULL, matrix_size, Xs[i], matrix_size);
-            free(EVI);
+            tpm_workspace *workspace = tpm_workspace_get();
+            for (int i = first; i < last; i++)
+            {
+                memcpy(workspace->work, Xs[i], (size_t)n * n * sizeof(double));
+                LAPACKE_dgeev_work(LAPACK_COL_MAJOR, 'N', 'V', n, workspace->work, n, EVs[i],
+                                   workspace->lapack + (size_t)n * n, NULL, n, workspace->lapack, n,
+                                   workspace->lapack + (size_t)n * n + n, lwork);
+            }
 
             TPM_application_task_finish("geev");
         }
 
-#pragma omp task depend(in : Us[i], VTs[i]) depend(out : Ms[i])
+#pragma omp task firstprivate(first, last) depend(in : Us[first][0 : n * n], VTs[first][0 : n * n]) \
+    depend(out : Ms[first][0 : n * n])
         {
             TPM_application_task_start("gemm");
 
-            cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
-                        matrix_size, matrix_size, matrix_size,
-                        1.0, Us[i], matrix_size, VTs[i], matrix_size,
-                        0.0, Ms[i], matrix_size);
+            for (int i = first; i < last; i++)
+            {
+                cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans, n, n, n,
+                            1.0, Us[i], n, VTs[i], n, 0.0, Ms[i], n);
+            }
 
             TPM_application_task_finish("gemm");
         }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,94 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  autotune.h
+ *
+ *    Description:  Choice of the inner block size of the QR kernels
+ *
+ *        Version:  1.0
+ *        Created:  19/10/2026
+ *       Revision:  none
+ *       Compiler:  clang
+ *
+ *         Author:  Idriss Daoudi <idaoudi@anl.gov>
+ *   Organization:  Argonne National Laboratory
+ *
+ * =====================================================================================
+ */
+
+// Columns of the tiles the reflectors are applied to, and runs of each
+// inner block size, the fastest one counting
+#define TPM_AUTOTUNE_COLUMNS 256
+#define TPM_AUTOTUNE_RUNS 3
+
+// Inner block size of the QR kernels for the tile size: the fastest of the
+// powers of two from 16 and of the tile size itself at applying the
+// reflectors of a tile to a pair of tiles, as tsmqr does with most of the
+// operations of QR. The time of each block of reflectors grows linearly with
+// the columns, so that a slice of them is enough. All the threads run the
+// kernel at once, on their own tiles, sharing the caches and the memory
+// bandwidth as in the factorization. The reflectors and their factors are
+// random but small, only the time matters
+int tpm_autotune_ib(int tile_size)
+{
+  int columns = min(tile_size, TPM_AUTOTUNE_COLUMNS);
+  size_t tile = (size_t)tile_size * tile_size;
+  double *V = malloc(tile * sizeof(double));
+  double *T = malloc(tile * sizeof(double));
+  if (V == NULL || T == NULL)
+  {
+    printf("Problem allocating the autotuning tiles.\n");
+    exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < tile; i++)
+  {
+    V[i] = ((double)(i * 7919 % 1000) / 1000.0 - 0.5) / sqrt(tile_size);
+    T[i] = ((double)(i * 104729 % 1000) / 1000.0 - 0.5) / tile_size;
+  }
+
+  int best = tile_size;
+  double best_time = 0.0;
+  for (int ib = min(16, tile_size);; ib = min(2 * ib, tile_size))
+  {
+    double time = 0.0;
+#pragma omp parallel reduction(max : time)
+    {
+      size_t slice = (size_t)tile_size * columns;
+      double *A1 = malloc(slice * sizeof(double));
+      double *A2 = malloc(slice * sizeof(double));
+      double *work = malloc((size_t)ib * columns * sizeof(double));
+      if (A1 == NULL || A2 == NULL || work == NULL)
+      {
+        printf("Problem allocating the autotuning tiles.\n");
+        exit(EXIT_FAILURE);
+      }
+      for (size_t i = 0; i < slice; i++)
+        A1[i] = A2[i] = (double)(i % 1000) / 1000.0;
+      time = -1.0;
+      for (int r = 0; r < TPM_AUTOTUNE_RUNS; r++)
+      {
+        double start = omp_get_wtime();
+        tpm_dtsmqr(tpm_left, tpm_transpose, tile_size, columns, tile_size,
+                   columns, tile_size, ib, A1, tile_size, A2, tile_size, V,
+                   tile_size, T, tile_size, work, ib);
+        double elapsed = omp_get_wtime() - start;
+        if (time < 0.0 || elapsed < time)
+          time = elapsed;
+      }
+      free(A1);
+      free(A2);
+      free(work);
+    }
+    if (best_time == 0.0 || time < best_time)
+    {
+      best = ib;
+      best_time = time;
+    }
+    if (ib == tile_size)
+      break;
+  }
+
+  free(V);
+  free(T);
+  return best;
+}
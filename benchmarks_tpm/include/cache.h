@@ -0,0 +1,153 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  cache.h
+ *
+ *    Description:  Persistent cache of the generated matrices
+ *
+ *        Version:  1.0
+ *        Created:  19/10/2026
+ *       Revision:  none
+ *       Compiler:  clang
+ *
+ *         Author:  Idriss Daoudi <idaoudi@anl.gov>
+ *   Organization:  Argonne National Laboratory
+ *
+ * =====================================================================================
+ */
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+// Directory of the cached matrices, from TPM_MATRIX_CACHE. A matrix is
+// generated once per generator, size, tile size and seed, and the following
+// runs read it back from the file instead of generating it again
+char *TPM_MATRIX_CACHE = NULL;
+
+#define TPM_CACHE_MAGIC "TPMMAT1"
+#define TPM_CACHE_HEADER 4096 // Tiles start on a page boundary
+
+// File header. The tiles follow, column after column, each one packed
+// (tile_size x tile_size, no padding) whatever the layout of the descriptor
+typedef struct
+{
+  char magic[8];
+  char generator[32];
+  int32_t m;
+  int32_t n;
+  int32_t tile_size;
+  int32_t reserved;
+  uint64_t seed;
+} tpm_cache_header;
+
+// Mapped file the tiles are read from, during the first touch
+static const double *tpm_cache_tiles = NULL;
+
+static void tpm_cache_path(char *path, size_t size, tpm_desc *A,
+                           const char *generator)
+{
+  snprintf(path, size, "%s/%s_%dx%d_%d_%llu.tpm", TPM_MATRIX_CACHE, generator,
+           A->m, A->n, A->tile_size, (unsigned long long)tpm_seed);
+}
+
+static void tpm_cache_tile(tpm_desc *desc, int m, int n)
+{
+  tpm_desc A = *desc;
+  const double *source = tpm_cache_tiles +
+                         ((size_t)m + (size_t)A.mt * n) * A.tile_size * A.tile_size;
+  double *dA = A(m, n);
+  for (int k = 0; k < A.tile_size; k++)
+    memcpy(dA + (size_t)k * A.tile_ld, source + (size_t)k * A.tile_size,
+           A.tile_size * sizeof(double));
+}
+
+// Read the matrix back from the cache, 1 if it is not there
+int tpm_matrix_cache_load(tpm_desc *A, const char *generator)
+{
+  char path[TPM_STRING_SIZE * 4];
+  tpm_cache_path(path, sizeof(path), A, generator);
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return 1;
+
+  struct stat st;
+  size_t tiles = (size_t)A->mt * A->nt * A->tile_size * A->tile_size;
+  size_t size = TPM_CACHE_HEADER + tiles * sizeof(double);
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size != size)
+  {
+    close(fd);
+    return 1;
+  }
+  char *file = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (file == MAP_FAILED)
+    return 1;
+
+  tpm_cache_header *header = (tpm_cache_header *)file;
+  if (strcmp(header->magic, TPM_CACHE_MAGIC) != 0 ||
+      strcmp(header->generator, generator) != 0 || header->m != A->m ||
+      header->n != A->n || header->tile_size != A->tile_size ||
+      header->seed != tpm_seed)
+  {
+    munmap(file, size);
+    return 1;
+  }
+  madvise(file, size, MADV_SEQUENTIAL);
+  tpm_cache_tiles = (const double *)(file + TPM_CACHE_HEADER);
+  tpm_matrix_desc_first_touch(A, tpm_cache_tile);
+  tpm_cache_tiles = NULL;
+  munmap(file, size);
+  return 0;
+}
+
+// Write the matrix to the cache, under a temporary name renamed once
+// complete so that concurrent runs never read a partial file
+void tpm_matrix_cache_store(tpm_desc *A, const char *generator)
+{
+  char path[TPM_STRING_SIZE * 4], temporary[TPM_STRING_SIZE * 5];
+  tpm_cache_path(path, sizeof(path), A, generator);
+  snprintf(temporary, sizeof(temporary), "%s.%d", path, (int)getpid());
+  FILE *file = fopen(temporary, "w");
+  if (file == NULL)
+  {
+    printf("Cannot write the matrix cache %s.\n", path);
+    return;
+  }
+
+  char header[TPM_CACHE_HEADER] = {0};
+  tpm_cache_header *h = (tpm_cache_header *)header;
+  snprintf(h->magic, sizeof(h->magic), "%s", TPM_CACHE_MAGIC);
+  snprintf(h->generator, sizeof(h->generator), "%s", generator);
+  h->m = A->m;
+  h->n = A->n;
+  h->tile_size = A->tile_size;
+  h->seed = tpm_seed;
+  int error = fwrite(header, sizeof(header), 1, file) != 1;
+
+  for (int n = 0; n < A->nt && !error; n++)
+  {
+    for (int m = 0; m < A->mt && !error; m++)
+    {
+      double *dA = tpm_tile_address(*A, m, n);
+      for (int k = 0; k < A->tile_size && !error; k++)
+        error = fwrite(dA + (size_t)k * A->tile_ld, sizeof(double),
+                       A->tile_size, file) != (size_t)A->tile_size;
+    }
+  }
+  if (fclose(file) != 0 || error || rename(temporary, path) != 0)
+  {
+    printf("Cannot write the matrix cache %s.\n", path);
+    unlink(temporary);
+  }
+}
+
+// Generate the matrix, or read it from the cache when enabled
+void tpm_cached_generator(tpm_desc A, const char *name,
+                          void (*generator)(tpm_desc))
+{
+  if (TPM_MATRIX_CACHE && tpm_matrix_cache_load(&A, name) == 0)
+    return;
+  generator(A);
+  if (TPM_MATRIX_CACHE)
+    tpm_matrix_cache_store(&A, name);
+}
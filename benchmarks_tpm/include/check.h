@@ -0,0 +1,253 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  check.h
+ *
+ *    Description:  Scaled residuals of the factorizations, to verify their results
+ *
+ *        Version:  1.0
+ *        Created:  19/10/2026
+ *       Revision:  none
+ *       Compiler:  clang
+ *
+ *         Author:  Idriss Daoudi <idaoudi@anl.gov>
+ *   Organization:  Argonne National Laboratory
+ *
+ * =====================================================================================
+ */
+
+// Residuals are scaled by the norm of the input, its order and the machine
+// epsilon, a correct factorization stays well below the threshold
+#define TPM_CHECK_THRESHOLD 60.0
+
+// Frobenius norm of an m x n matrix of leading dimension lda
+static double tpm_check_norm(const double *A, int m, int n, int lda)
+{
+  double sum = 0.0;
+#pragma omp parallel for reduction(+ : sum) schedule(static)
+  for (int j = 0; j < n; j++)
+    for (int i = 0; i < m; i++)
+      sum += A[(size_t)j * lda + i] * A[(size_t)j * lda + i];
+  return sqrt(sum);
+}
+
+// R = A0 - R, both m x n of leading dimension lda
+static void tpm_check_subtract(const double *A0, double *R, int m, int n,
+                               int lda)
+{
+#pragma omp parallel for schedule(static)
+  for (int j = 0; j < n; j++)
+    for (int i = 0; i < m; i++)
+      R[(size_t)j * lda + i] = A0[(size_t)j * lda + i] - R[(size_t)j * lda + i];
+}
+
+// Zero the elements below the diagonal, or above it with upper set
+static void tpm_check_triangle(double *A, int m, int n, int lda, int upper)
+{
+#pragma omp parallel for schedule(static)
+  for (int j = 0; j < n; j++)
+    for (int i = 0; i < m; i++)
+      if ((upper && i < j) || (!upper && i > j))
+        A[(size_t)j * lda + i] = 0.0;
+}
+
+// LAPACKE layout copy of the tile matrix, the input kept for the check
+double *tpm_check_copy(tpm_desc A)
+{
+  double *A0 = malloc((size_t)A.m * A.n * sizeof(double));
+  if (A0 == NULL)
+  {
+    printf("Problem allocating the check copy.\n");
+    exit(EXIT_FAILURE);
+  }
+  tpm_tile_to_matrix(A, 0, 0, A.mt, A.nt, A0, A.m);
+  return A0;
+}
+
+// ||A - U^T U|| / (||A|| n eps), with the factor in the upper triangle
+double tpm_check_cholesky(tpm_desc A, const double *A0)
+{
+  int n = A.n;
+  double *U = tpm_check_copy(A);
+  double *R = malloc((size_t)n * n * sizeof(double));
+  tpm_check_triangle(U, n, n, n, 0);
+  memcpy(R, U, (size_t)n * n * sizeof(double));
+  cblas_dtrmm(CblasColMajor, CblasLeft, CblasUpper, CblasTrans, CblasNonUnit,
+              n, n, 1.0, U, n, R, n);
+  tpm_check_subtract(A0, R, n, n, n);
+
+  double residual = tpm_check_norm(R, n, n, n) /
+                    (tpm_check_norm(A0, n, n, n) * n * LAPACKE_dlamch('e'));
+  free(U);
+  free(R);
+  return residual;
+}
+
+// ||A - Q R|| / (||A|| max(m, n) eps). The reflectors and their triangular
+// factors left in A and S apply Q to R in the tile layout, the tile columns
+// independently of each other, in the reverse order of the flat or binary
+// tree of the factorization
+double tpm_check_qr(tpm_desc A, tpm_desc S, const double *A0)
+{
+  tpm_desc B = tpm_matrix_desc_init(A.tile_size, A.m, A.n);
+  double *R = tpm_check_copy(A);
+  if (tpm_matrix_desc_alloc(&B))
+  {
+    printf("Problem allocating the check copy.\n");
+    exit(EXIT_FAILURE);
+  }
+  tpm_check_triangle(R, A.m, A.n, A.m, 0);
+  tpm_matrix_to_tile(B, 0, 0, B.mt, B.nt, R, A.m);
+
+  for (int k = min(A.mt, A.nt) - 1; k >= 0; k--)
+  {
+    int tempkm = tpm_tile_rows(A, k);
+    int tempkn = tpm_tile_cols(A, k);
+#pragma omp parallel for schedule(dynamic)
+    for (int n = k; n < A.nt; n++)
+    {
+      int tempnn = tpm_tile_cols(A, n);
+      double *work = malloc((size_t)S.tile_size * A.tile_size * sizeof(double));
+      if (QR_TREE)
+      {
+        // The levels of the tree from the root, then the geqrt of each tile
+        int top = 1;
+        while (k + 2 * top < A.mt)
+          top *= 2;
+        for (int step = top; step > 0; step /= 2)
+          for (int m = k; m + step < A.mt; m += 2 * step)
+            tpm_dttmqr(tpm_left, tpm_notranspose, tpm_tile_rows(A, m), tempnn,
+                       tpm_tile_rows(A, m + step), tempnn, tempkn, S.ib,
+                       B(m, n), B.tile_ld, B(m + step, n), B.tile_ld,
+                       A(m + step, k), A.tile_ld, S(A.mt + m + step, k),
+                       S.tile_ld, work, S.ib);
+        for (int m = k; m < A.mt; m++)
+        {
+          int tempmm = tpm_tile_rows(A, m);
+          tpm_dormqr(tpm_left, tpm_notranspose, tempmm, tempnn,
+                     min(tempmm, tempkn), S.ib, A(m, k), A.tile_ld,
+                     S(m, k), S.tile_ld, B(m, n), B.tile_ld, work, tempnn);
+        }
+      }
+      else
+      {
+        for (int m = A.mt - 1; m > k; m--)
+          tpm_dtsmqr(tpm_left, tpm_notranspose, tempkm, tempnn,
+                     tpm_tile_rows(A, m), tempnn, tempkn, S.ib, B(k, n),
+                     B.tile_ld, B(m, n), B.tile_ld, A(m, k), A.tile_ld,
+                     S(m, k), S.tile_ld, work, S.ib);
+        tpm_dormqr(tpm_left, tpm_notranspose, tempkm, tempnn,
+                   min(tempkm, tempkn), S.ib, A(k, k), A.tile_ld,
+                   S(k, k), S.tile_ld, B(k, n), B.tile_ld, work, tempnn);
+      }
+      free(work);
+    }
+  }
+
+  tpm_tile_to_matrix(B, 0, 0, B.mt, B.nt, R, A.m);
+  tpm_check_subtract(A0, R, A.m, A.n, A.m);
+  double residual = tpm_check_norm(R, A.m, A.n, A.m) /
+                    (tpm_check_norm(A0, A.m, A.n, A.m) * max(A.m, A.n) *
+                     LAPACKE_dlamch('e'));
+  free(R);
+  tpm_matrix_desc_free(&B);
+  return residual;
+}
+
+// ||P A - L U|| / (||A|| n eps), with the row interchanges of ipiv applied
+// to the copy of the input A0
+double tpm_check_lu(tpm_desc A, const int *ipiv, double *A0)
+{
+  int n = A.n;
+  double *F = tpm_check_copy(A);
+  double *R = malloc((size_t)n * n * sizeof(double));
+  memcpy(R, F, (size_t)n * n * sizeof(double));
+  tpm_check_triangle(R, n, n, n, 0);
+  cblas_dtrmm(CblasColMajor, CblasLeft, CblasLower, CblasNoTrans, CblasUnit,
+              n, n, 1.0, F, n, R, n);
+  LAPACKE_dlaswp(LAPACK_COL_MAJOR, n, A0, n, 1, n, ipiv, 1);
+  tpm_check_subtract(A0, R, n, n, n);
+
+  double residual = tpm_check_norm(R, n, n, n) /
+                    (tpm_check_norm(A0, n, n, n) * n * LAPACKE_dlamch('e'));
+  free(F);
+  free(R);
+  return residual;
+}
+
+// ||A X - I|| / (||A|| ||X|| n eps), for the computed inverse X of A in the
+// tile matrix
+double tpm_check_invert(tpm_desc X, const double *A0)
+{
+  int n = X.n;
+  double *inverse = tpm_check_copy(X);
+  double *R = malloc((size_t)n * n * sizeof(double));
+  double *identity = calloc((size_t)n * n, sizeof(double));
+  for (int i = 0; i < n; i++)
+    identity[(size_t)i * n + i] = 1.0;
+  cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans, n, n, n, 1.0, A0, n,
+              inverse, n, 0.0, R, n);
+  tpm_check_subtract(identity, R, n, n, n);
+
+  double residual = tpm_check_norm(R, n, n, n) /
+                    (tpm_check_norm(A0, n, n, n) *
+                     tpm_check_norm(inverse, n, n, n) * n * LAPACKE_dlamch('e'));
+  free(inverse);
+  free(R);
+  free(identity);
+  return residual;
+}
+
+// Dense copy of the sparse tile matrix, the empty tiles as zeros
+static double *tpm_check_sparse_dense(double **M, int tiles, int tile_size)
+{
+  int n = tiles * tile_size;
+  double *D = calloc((size_t)n * n, sizeof(double));
+#pragma omp parallel for schedule(static)
+  for (int i = 0; i < tiles; i++)
+    for (int j = 0; j < tiles; j++)
+      if (M[i * tiles + j] != NULL)
+        for (int r = 0; r < tile_size; r++)
+          memcpy(D + ((size_t)i * tile_size + r) * n + (size_t)j * tile_size,
+                 M[i * tiles + j] + r * tile_size, tile_size * sizeof(double));
+  return D;
+}
+
+// ||A - L U|| / (||A|| n eps) of the sparse LU, whose tiles are stored row
+// by row. The input is generated again, the generator being deterministic
+double tpm_check_sparselu(double **M, int tiles, int tile_size)
+{
+  int n = tiles * tile_size;
+  double **M0;
+  tpm_sparse_allocate(&M0, tiles, tile_size);
+  double *A0 = tpm_check_sparse_dense(M0, tiles, tile_size);
+  for (int i = 0; i < tiles * tiles; i++)
+    free(M0[i]);
+  free(M0);
+
+  double *F = tpm_check_sparse_dense(M, tiles, tile_size);
+  double *R = malloc((size_t)n * n * sizeof(double));
+  memcpy(R, F, (size_t)n * n * sizeof(double));
+  // The row by row storage is the transposed column major one
+  tpm_check_triangle(R, n, n, n, 1);
+  cblas_dtrmm(CblasRowMajor, CblasLeft, CblasLower, CblasNoTrans, CblasUnit,
+              n, n, 1.0, F, n, R, n);
+  tpm_check_subtract(A0, R, n, n, n);
+
+  double residual = tpm_check_norm(R, n, n, n) /
+                    (tpm_check_norm(A0, n, n, n) * n * LAPACKE_dlamch('e'));
+  free(A0);
+  free(F);
+  free(R);
+  return residual;
+}
+
+// Print the residual, 1 if above the threshold
+int tpm_check_report(const char *algorithm, double residual)
+{
+  int failed = !(residual < TPM_CHECK_THRESHOLD);
+  printf("algorithm,matrix_size,tile_size,residual,check\n");
+  printf("%s,%d,%d,%e,%s\n", algorithm, MSIZE, BSIZE, residual,
+         failed ? "FAILED" : "PASSED");
+  return failed;
+}
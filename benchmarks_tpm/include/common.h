@@ -27,6 +27,7 @@
 #include <unistd.h>
 #include <pthread.h>
 #include <stdbool.h>
+#include <omp.h>
 
 #include <papi.h>
 
@@ -34,12 +35,32 @@
 
 double time_start, time_finish;
 
+// Time spent in each task type, accumulated between the task start and
+// finish when tpm_task_timing is set. The types are registered before the
+// run, the tasks of other types are not timed
+#define TPM_TASK_TYPES 16
+int tpm_task_timing = 0;
+int tpm_task_types = 0;
+char tpm_task_names[TPM_TASK_TYPES][TPM_STRING_SIZE];
+double tpm_task_times[TPM_TASK_TYPES];
+static __thread double tpm_task_time_start;
+
+// Index of a registered task type, -1 if unknown
+static inline int tpm_task_type(const char *task_name)
+{
+  for (int t = 0; t < tpm_task_types; t++)
+    if (strcmp(tpm_task_names[t], task_name) == 0)
+      return t;
+  return -1;
+}
+
 /* TPM modifications start */
 /* Weak attributes */
 void __attribute__((weak)) TPM_middle_man_start();
 void __attribute__((weak)) TPM_middle_man_finalize(double total_execution_time);
 void __attribute__((weak)) TPM_middle_man_task_start(const char *task_name);
 void __attribute__((weak)) TPM_middle_man_task_finish(const char *task_name);
+void __attribute__((weak)) TPM_middle_man_energy(int window);
 
 /* Application tracing functions */
 static inline void TPM_application_start()
@@ -53,11 +74,29 @@ static inline void TPM_application_finalize(double total_execution_time)
 static inline void TPM_application_task_start(const char *task_name)
 {
   TPM_middle_man_task_start(task_name);
+  if (tpm_task_timing)
+    tpm_task_time_start = omp_get_wtime();
 }
 static inline void TPM_application_task_finish(const char *task_name)
 {
+  if (tpm_task_timing)
+  {
+    double time = omp_get_wtime() - tpm_task_time_start;
+    int t = tpm_task_type(task_name);
+    if (t >= 0)
+    {
+#pragma omp atomic
+      tpm_task_times[t] += time;
+    }
+  }
   TPM_middle_man_task_finish(task_name);
 }
+// Energy window around a measured repetition, if the tracer knows about it
+static inline void TPM_application_energy(int window)
+{
+  if (TPM_middle_man_energy)
+    TPM_middle_man_energy(window);
+}
 /* TPM modifications end */
 
 // Give a task name a unique identification according to iterations
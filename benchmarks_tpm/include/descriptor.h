@@ -16,50 +16,262 @@
  * =====================================================================================
  */
 
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+// Memory policies of mbind(2), without depending on libnuma
+#define TPM_MPOL_PREFERRED 1
+#define TPM_MAX_NUMA_NODES 64
 
 // Definition of descriptor structure
 typedef struct tpm_descriptor_t
 {
   int tile_size;
+  int tile_ld; // Leading dimension of the tiles, tile_size plus padding
+  int ib;      // Inner block size of the kernels, at most tile_size
   long int matrix_nelements;
-  long int tile_nelements;
-  int matrix_size;
+  long int tile_nelements; // Stride between two tiles, aligned
+  int m;  // Rows of the matrix
+  int n;  // Columns of the matrix
+  int mt; // Tile rows, the last one ragged when tile_size does not divide m
+  int nt; // Tile columns, likewise
   void *matrix;
+  size_t mapped_size; // Non zero when the storage is mapped by tpm_matrix_desc_alloc
+  int hugepages;      // Pages obtained, as in TPM_HUGEPAGES, THP once enabled and advised
+  int numa_nodes;     // Nodes the tiles are distributed over
+  int numa_rows;      // Rows of the nodes grid (numa_rows x numa_nodes / numa_rows)
 } tpm_desc;
 
-// Matrix descriptor initialization
-tpm_desc tpm_matrix_desc_init(int tile_size, long int matrix_nelements,
-                              long int tile_nelements, int matrix_size)
+// Layout and placement options, from the environment:
+// TPM_TILE_PAD adds doubles to the leading dimension of the tiles, so that
+// power of two tile sizes do not map their columns to the same cache sets
+// TPM_TILE_ALIGN aligns every tile on that many bytes (a multiple of 8)
+// TPM_NUMA=0 leaves the pages where the kernel puts them
+// TPM_HUGEPAGES=1 asks for transparent huge pages, 2 for hugetlbfs pages
+int TPM_TILE_PAD = 0;
+int TPM_TILE_ALIGN = 64;
+int TPM_NUMA = 1;
+int TPM_HUGEPAGES = 0;
+
+// Matrix descriptor initialization, for an m x n matrix. Ragged tiles of the
+// last tile row and column are stored in full size tiles
+tpm_desc tpm_matrix_desc_init(int tile_size, int m, int n)
 {
   tpm_desc desc;
   desc.matrix = NULL;
   desc.tile_size = tile_size;
-  desc.matrix_nelements = matrix_nelements;
-  desc.tile_nelements = tile_nelements;
-  desc.matrix_size = matrix_size;
+  desc.tile_ld = tile_size + TPM_TILE_PAD;
+  desc.ib = tile_size;
+  desc.matrix_nelements = (long int)m * n;
+  long int align = TPM_TILE_ALIGN / sizeof(double) > 0 ? TPM_TILE_ALIGN / sizeof(double) : 1;
+  long int stride = (long int)desc.tile_ld * tile_size;
+  desc.tile_nelements = (stride + align - 1) / align * align;
+  desc.m = m;
+  desc.n = n;
+  desc.mt = (m + tile_size - 1) / tile_size;
+  desc.nt = (n + tile_size - 1) / tile_size;
+  desc.mapped_size = 0;
+  desc.hugepages = 0;
+  desc.numa_nodes = 1;
+  desc.numa_rows = 1;
   return desc;
 }
 
 // Matrix descriptor creation
-int tpm_matrix_desc_create(tpm_desc **desc, void *matrix, int tile_size,
-                           long int matrix_nelements, long int tile_nelements,
-                           int matrix_size)
+int tpm_matrix_desc_create(tpm_desc **desc, void *matrix, int tile_size, int m,
+                           int n)
 {
   *desc = (tpm_desc *)malloc(sizeof(tpm_desc));
-  **desc = tpm_matrix_desc_init(tile_size, matrix_nelements, tile_nelements,
-                                matrix_size);
+  **desc = tpm_matrix_desc_init(tile_size, m, n);
   (**desc).matrix = matrix;
   return 0;
 }
 
-// Matrix descriptor allocation
+// Number of online NUMA nodes, from the highest one in the online list
+int tpm_numa_nodes()
+{
+  FILE *file = fopen("/sys/devices/system/node/online", "r");
+  if (file == NULL)
+    return 1;
+  int nodes = 1, first, last;
+  while (fscanf(file, "%d", &first) == 1)
+  {
+    last = first;
+    if (fscanf(file, "-%d", &last) != 1)
+      last = first;
+    nodes = last + 1;
+    if (fgetc(file) != ',')
+      break;
+  }
+  fclose(file);
+  return nodes < TPM_MAX_NUMA_NODES ? nodes : TPM_MAX_NUMA_NODES;
+}
+
+// Whether the kernel backs advised mappings with transparent huge pages
+int tpm_thp_enabled()
+{
+  FILE *file = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+  if (file == NULL)
+    return 0;
+  char mode[64] = {0};
+  int enabled = fgets(mode, sizeof(mode), file) != NULL && strstr(mode, "[never]") == NULL;
+  fclose(file);
+  return enabled;
+}
+
+// Node owning tile (m, n): 2D block-cyclic over a grid of nodes
+static inline int tpm_tile_owner(tpm_desc *desc, int m, int n)
+{
+  return (m % desc->numa_rows) +
+         desc->numa_rows * (n % (desc->numa_nodes / desc->numa_rows));
+}
+
+// Prefer the owner node for the pages of each tile. Pages shared by two
+// tiles go to the owner of the last one
+static void tpm_matrix_desc_bind(tpm_desc *desc)
+{
+  size_t page = getpagesize();
+  size_t tile_bytes = desc->tile_nelements * sizeof(double);
+  for (int n = 0; n < desc->nt; n++)
+  {
+    for (int m = 0; m < desc->mt; m++)
+    {
+      char *start = (char *)desc->matrix + (size_t)(m + desc->mt * n) * tile_bytes;
+      char *first = (char *)((uintptr_t)start & ~(page - 1));
+      unsigned long mask = 1UL << tpm_tile_owner(desc, m, n);
+      if (syscall(SYS_mbind, first, start + tile_bytes - first, TPM_MPOL_PREFERRED,
+                  &mask, sizeof(mask) * 8, 0) != 0)
+      {
+        // No NUMA support in the kernel, first touch decides alone
+        return;
+      }
+    }
+  }
+}
+
+// Parallel first touch: the threads of each node zero the tiles it owns,
+// or fill them when given a fill function. Tiles of nodes without threads
+// are shared by all
+static void tpm_matrix_desc_first_touch(tpm_desc *desc,
+                                        void (*fill)(tpm_desc *, int, int))
+{
+  int threads = omp_get_max_threads();
+  int *thread_node = (int *)calloc(threads, sizeof(int));
+  size_t tile_bytes = desc->tile_nelements * sizeof(double);
+
+#pragma omp parallel num_threads(threads)
+  {
+    int me = omp_get_thread_num();
+    unsigned int cpu, node = 0;
+    syscall(SYS_getcpu, &cpu, &node, NULL);
+    thread_node[me] = (int)node % desc->numa_nodes;
+#pragma omp barrier
+
+    int rank = 0, peers = 0, team = omp_get_num_threads();
+    int has_threads[TPM_MAX_NUMA_NODES] = {0};
+    for (int t = 0; t < team; t++)
+    {
+      has_threads[thread_node[t]] = 1;
+      if (thread_node[t] == thread_node[me])
+      {
+        rank += t < me;
+        peers++;
+      }
+    }
+
+    int mine = 0, shared = 0;
+    for (int n = 0; n < desc->nt; n++)
+    {
+      for (int m = 0; m < desc->mt; m++)
+      {
+        int owner = tpm_tile_owner(desc, m, n);
+        int touch;
+        if (has_threads[owner])
+          touch = owner == thread_node[me] && mine++ % peers == rank;
+        else
+          touch = shared++ % team == me;
+        if (touch && fill)
+          fill(desc, m, n);
+        else if (touch)
+          memset((char *)desc->matrix + (size_t)(m + desc->mt * n) * tile_bytes, 0, tile_bytes);
+      }
+    }
+  }
+  free(thread_node);
+}
+
+// Matrix descriptor allocation: anonymous mapping, optionally backed by huge
+// pages, with tiles distributed block-cyclically over the NUMA nodes and
+// placed by a parallel first touch
 int tpm_matrix_desc_alloc(tpm_desc *desc)
 {
-  size_t size;
-  size = desc->matrix_size * desc->matrix_size * sizeof(double);
-  desc->matrix = malloc(size);
+  size_t size = (size_t)desc->mt * desc->nt * desc->tile_nelements * sizeof(double);
+  size_t huge = 2UL << 20;
+  size_t mapped = (size + huge - 1) & ~(huge - 1);
+  void *matrix = MAP_FAILED;
+
+  if (TPM_HUGEPAGES == 2)
+  {
+    matrix = mmap(NULL, mapped, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (matrix == MAP_FAILED)
+      printf("No hugetlbfs pages available, falling back to normal pages.\n");
+  }
+  int hugepages = matrix != MAP_FAILED ? 2 : 0;
+  if (matrix == MAP_FAILED)
+  {
+    // Over allocated by a huge page and trimmed to a 2 MB boundary, so that
+    // the first and last huge pages can be backed too
+    size_t extra = TPM_HUGEPAGES == 1 ? huge : 0;
+    char *start = mmap(NULL, mapped + extra, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (start == MAP_FAILED)
+      return 1;
+    matrix = start;
+    if (extra)
+    {
+      matrix = (void *)(((uintptr_t)start + huge - 1) & ~(huge - 1));
+      size_t head = (char *)matrix - start;
+      if (head)
+        munmap(start, head);
+      if (extra - head)
+        munmap((char *)matrix + mapped, extra - head);
+      if (tpm_thp_enabled() && madvise(matrix, mapped, MADV_HUGEPAGE) == 0)
+        hugepages = 1;
+      else
+        printf("No transparent huge pages available, falling back to normal pages.\n");
+    }
+  }
+  desc->matrix = matrix;
+  desc->mapped_size = mapped;
+  desc->hugepages = hugepages;
+
+  desc->numa_nodes = TPM_NUMA ? tpm_numa_nodes() : 1;
+  desc->numa_rows = 1;
+  for (int p = 1; p * p <= desc->numa_nodes; p++)
+  {
+    if (desc->numa_nodes % p == 0)
+      desc->numa_rows = desc->numa_nodes / p;
+  }
+  if (desc->numa_nodes > 1)
+    tpm_matrix_desc_bind(desc);
+  tpm_matrix_desc_first_touch(desc, NULL);
+  return 0;
+}
+
+// Matrix descriptor storage release
+int tpm_matrix_desc_free(tpm_desc *desc)
+{
+  if (desc->mapped_size)
+    munmap(desc->matrix, desc->mapped_size);
+  else
+    free(desc->matrix);
+  desc->matrix = NULL;
+  desc->mapped_size = 0;
   return 0;
 }
 
@@ -0,0 +1,161 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  flops.h
+ *
+ *    Description:  Floating point operation counts of the algorithms
+ *
+ *        Version:  1.0
+ *        Created:  19/10/2026
+ *       Revision:  none
+ *       Compiler:  clang
+ *
+ *         Author:  Idriss Daoudi <idaoudi@anl.gov>
+ *   Organization:  Argonne National Laboratory
+ *
+ * =====================================================================================
+ */
+
+// Operation counts (multiplications plus additions) from LAPACK Working Note 41
+
+// Cholesky factorization of an n x n matrix (dpotrf)
+static inline double tpm_flops_potrf(double n)
+{
+  return n * n * n / 3.0 + n * n / 2.0 + n / 6.0;
+}
+
+// QR factorization of an m x n matrix (dgeqrf)
+static inline double tpm_flops_geqrf(double m, double n)
+{
+  double fmuls, fadds;
+  if (m >= n)
+  {
+    fmuls = m * n * n - n * n * n / 3.0 + m * n + n * n / 2.0 + 23.0 * n / 6.0;
+    fadds = m * n * n - n * n * n / 3.0 + n * n / 2.0 + 5.0 * n / 6.0;
+  }
+  else
+  {
+    fmuls = n * m * m - m * m * m / 3.0 + 2.0 * n * m - m * m / 2.0 + 23.0 * m / 6.0;
+    fadds = n * m * m - m * m * m / 3.0 + n * m - m * m / 2.0 + 5.0 * m / 6.0;
+  }
+  return fmuls + fadds;
+}
+
+// LU factorization with partial pivoting of an m x n matrix (dgetrf)
+static inline double tpm_flops_getrf(double m, double n)
+{
+  double k = min(m, n), l = max(m, n);
+  double fmuls = 0.5 * k * (k * (l - k / 3.0 - 1.0) + l) + 2.0 * k / 3.0;
+  double fadds = 0.5 * k * (k * (l - k / 3.0) - l) + k / 6.0;
+  return fmuls + fadds;
+}
+
+// Inverse from the LU factors of an n x n matrix (dgetri)
+static inline double tpm_flops_getri(double n)
+{
+  double fmuls = n * (5.0 / 6.0 + n * (2.0 / 3.0 * n + 0.5));
+  double fadds = n * (5.0 / 6.0 + n * (2.0 / 3.0 * n - 1.5));
+  return fmuls + fadds;
+}
+
+/* Tile kernels, for the task types of the algorithms */
+
+// C (m x n) += A (m x k) * B (k x n)
+static inline double tpm_flops_gemm(double m, double n, double k)
+{
+  return 2.0 * m * n * k;
+}
+
+// Triangular solve with m x m on the left of an m x n matrix
+static inline double tpm_flops_trsm(double m, double n)
+{
+  return m * m * n;
+}
+
+// Inverse of an n x n triangular matrix (dtrtri)
+static inline double tpm_flops_trtri(double n)
+{
+  double fmuls = n * (1.0 / 3.0 + n * (0.5 + n / 6.0));
+  double fadds = n * (2.0 / 3.0 + n * (-0.5 + n / 6.0));
+  return fmuls + fadds;
+}
+
+// C (n x n, one triangle) += A^T (n x k) * A
+static inline double tpm_flops_syrk(double n, double k)
+{
+  return k * n * (n + 1.0);
+}
+
+// Application of k reflectors of an m x k tile to an m x n tile (dormqr)
+static inline double tpm_flops_ormqr(double m, double n, double k)
+{
+  return 4.0 * n * m * k - 2.0 * n * k * k + 3.0 * n * k;
+}
+
+// QR factorization of an n x n triangle on top of an m x n tile, without the
+// triangular factors
+static inline double tpm_flops_tsqrt(double m, double n)
+{
+  return 2.0 * m * n * n + 2.0 * m * n;
+}
+
+// Application of the k reflectors of a tpm_dtsqrt, of length m2, to a k x n
+// tile on top of an m2 x n tile
+static inline double tpm_flops_tsmqr(double m2, double n, double k)
+{
+  return 4.0 * m2 * n * k + 2.0 * k * n;
+}
+
+// QR factorization of an n x n triangle on top of another, the reflectors
+// as long as their column in the triangle
+static inline double tpm_flops_ttqrt(double n)
+{
+  return 2.0 / 3.0 * n * n * n;
+}
+
+// Application of the k reflectors of a tpm_dttqrt to a k x n tile on top of
+// another
+static inline double tpm_flops_ttmqr(double n, double k)
+{
+  return 2.0 * k * k * n;
+}
+
+// Sylvester equation with n x n quasi-triangular matrices (dtrsyl)
+static inline double tpm_flops_trsyl(double n)
+{
+  return 2.0 * n * n * n;
+}
+
+// SVD of an n x n matrix with all the singular vectors (Golub and Van Loan)
+static inline double tpm_flops_gesvd(double n)
+{
+  return 21.0 * n * n * n;
+}
+
+// Eigenvalues and right eigenvectors of an n x n matrix (Golub and Van Loan)
+static inline double tpm_flops_geev(double n)
+{
+  return 26.0 * n * n * n;
+}
+
+// Sparse LU tile kernels, without pivoting: factorization of the diagonal
+// tile, solves with its unit lower and upper factors, and update
+static inline double tpm_flops_lu0(double n)
+{
+  return n * (n - 1.0) / 2.0 + n * (n - 1.0) * (2.0 * n - 1.0) / 3.0;
+}
+
+static inline double tpm_flops_fwd(double n)
+{
+  return n * n * (n - 1.0);
+}
+
+static inline double tpm_flops_bdiv(double n)
+{
+  return n * n * n;
+}
+
+static inline double tpm_flops_bmod(double n)
+{
+  return 2.0 * n * n * n;
+}
@@ -16,12 +16,71 @@
  * =====================================================================================
  */
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <time.h>
 
 // #define SPECIAL4x4 1
 // #define IDENTITY 1
 
+// Seed of the generators, from the time unless given on the command line
+uint64_t tpm_seed = 0;
+
+// Counter based generator: element (i, j) of matrix stream is a pure
+// function of (seed, stream, i, j) through the splitmix64 mixer, so the
+// matrices do not depend on the tile size, the thread count or the order in
+// which the elements are generated
+static inline uint64_t tpm_splitmix64(uint64_t x)
+{
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+// Uniform in [0, 1)
+static inline double tpm_random(uint64_t stream, uint64_t i, uint64_t j)
+{
+  uint64_t key = tpm_splitmix64(tpm_seed ^ tpm_splitmix64(stream));
+  uint64_t z = tpm_splitmix64(key ^ ((i << 32) | (j & 0xffffffffULL)));
+  return (z >> 11) * 0x1.0p-53;
+}
+
+// Tile (m, n) of the hermitian positive matrix
+static void tpm_hermitian_positive_tile(tpm_desc *desc, int m, int n)
+{
+  tpm_desc A = *desc;
+  double *dA = A(m, n);
+  for (int k = 0; k < tpm_tile_cols(A, n); k++)
+  {
+    for (int l = 0; l < tpm_tile_rows(A, m); l++)
+    {
+      long int row = (long int)m * A.tile_size + l;
+      long int col = (long int)n * A.tile_size + k;
+      // Random diagonal elements on the diagonal of the matrix
+      if (row == col)
+      {
+#ifdef IDENTITY
+        dA[k * A.tile_ld + l] = 1.0;
+#else
+        double seed = 173.0;
+        dA[k * A.tile_ld + l] = tpm_random(0, row, col) * seed + seed;
+#endif
+      }
+      // Fixed small value for all the rest
+      else
+      {
+#ifdef IDENTITY
+        dA[k * A.tile_ld + l] = 0.0;
+#else
+        dA[k * A.tile_ld + l] = 0.5;
+#endif
+      }
+    }
+  }
+}
+
+// Tiles generated by the threads of the NUMA node owning them
 void tpm_hermitian_positive_generator(tpm_desc A)
 {
 #ifdef SPECIAL4x4
@@ -46,47 +105,34 @@ void tpm_hermitian_positive_generator(tpm_desc A)
   dA[2] = 0.342457;
   dA[3] = 3.982519;
 #else
-  srand((unsigned int)time(NULL));
-  for (int i = 0; i < A.matrix_size / A.tile_size; i++)
-  {
-    for (int j = 0; j < A.matrix_size / A.tile_size; j++)
-    {
-      double *dA = A(i, j);
-      for (int k = 0; k < A.tile_size; k++)
-      {
-        for (int l = 0; l < A.tile_size; l++)
-        {
-          // Random diagonal elements on the diagonal tiles of matrix
-          if (i == j && k == l)
-          {
-#ifdef IDENTITY
-            dA[k * A.tile_size + l] = 1.0;
-#else
-            double seed = 173.0;
-            dA[k * A.tile_size + l] =
-                ((double)rand() / (double)(RAND_MAX)) * seed + seed;
-#endif
-          }
-          // Fixed small value for all the rest
-          else
-          {
-#ifdef IDENTITY
-            dA[k * A.tile_size + l] = 0.0;
-#else
-            dA[k * A.tile_size + l] = 0.5;
-#endif
-          }
-        }
-      }
-    }
-  }
+  tpm_matrix_desc_first_touch(&A, tpm_hermitian_positive_tile);
 #endif
 }
 
+// Structure of the sparse matrix, 1 if the tile (m, n) is initially non zero
+static int tpm_sparse_nonzero(int m, int n)
+{
+  int zero_element = 0;
+  if ((m < n) && (m % 3 != 0))
+    zero_element = 1;
+  if ((m > n) && (n % 3 != 0))
+    zero_element = 1;
+  if (m % 2 == 1)
+    zero_element = 1;
+  if (n % 2 == 1)
+    zero_element = 1;
+  if (m == n)
+    zero_element = 0;
+  if (m == n - 1)
+    zero_element = 0;
+  if (m - 1 == n)
+    zero_element = 0;
+  return !zero_element;
+}
+
 static void tpm_sparse_generator(double *M[], int matrix_size, int tile_size)
 {
   int init_val = 1325;
-  int zero_element = 0;
   int i, j, m, n;
 
   // Generating the structure
@@ -95,24 +141,8 @@ static void tpm_sparse_generator(double *M[], int matrix_size, int tile_size)
     for (n = 0; n < matrix_size; n++)
     {
       double *p;
-      // Computing null entries
-      zero_element = 0;
-      if ((m < n) && (m % 3 != 0))
-        zero_element = 1;
-      if ((m > n) && (n % 3 != 0))
-        zero_element = 1;
-      if (m % 2 == 1)
-        zero_element = 1;
-      if (n % 2 == 1)
-        zero_element = 1;
-      if (m == n)
-        zero_element = 0;
-      if (m == n - 1)
-        zero_element = 0;
-      if (m - 1 == n)
-        zero_element = 0;
       // Allocating matrix
-      if (zero_element == 0)
+      if (tpm_sparse_nonzero(m, n))
       {
         M[m * matrix_size + n] =
             (double *)malloc(tile_size * tile_size * sizeof(double));
@@ -129,6 +159,9 @@ static void tpm_sparse_generator(double *M[], int matrix_size, int tile_size)
           {
             init_val = (3125 * init_val) % 65536;
             (*p) = (double)((init_val - 32768.0) / 16384.0);
+            // Diagonally dominant, the LU does not pivot
+            if (m == n && i == j)
+              (*p) += 2.0 * matrix_size * tile_size;
             p++;
           }
         }
@@ -147,13 +180,36 @@ static void tpm_sparse_allocate(double ***M, int matrix_size, int tile_size)
   tpm_sparse_generator(*M, matrix_size, tile_size);
 }
 
-void tpm_dense_generator(double *mat, int elements)
+// Matrix stream of size elements x elements, generated in parallel
+void tpm_dense_generator(double *mat, int elements, int stream)
 {
+#pragma omp parallel for schedule(static)
   for (int i = 0; i < elements; i++)
   {
     for (int j = 0; j < elements; j++)
     {
-      mat[i * elements + j] = ((double)rand() / (RAND_MAX)) * 10.;
+      mat[(long int)i * elements + j] = tpm_random(stream, i, j) * 10.;
+    }
+  }
+}
+
+// Tile (m, n) of the dense matrix stream 0
+static void tpm_dense_tile(tpm_desc *desc, int m, int n)
+{
+  tpm_desc A = *desc;
+  double *dA = A(m, n);
+  for (int k = 0; k < tpm_tile_cols(A, n); k++)
+  {
+    for (int l = 0; l < tpm_tile_rows(A, m); l++)
+    {
+      dA[k * A.tile_ld + l] = tpm_random(0, (long int)n * A.tile_size + k,
+                                         (long int)m * A.tile_size + l) * 10.;
     }
   }
-}
\ No newline at end of file
+}
+
+// Same values as tpm_dense_generator stream 0, in tile layout
+void tpm_dense_tile_generator(tpm_desc A)
+{
+  tpm_matrix_desc_first_touch(&A, tpm_dense_tile);
+}
@@ -20,54 +20,50 @@
 
 void tpm_print_matrix(tpm_desc A)
 {
-  double *B = malloc(A.matrix_size * A.matrix_size * sizeof(double));
-  int matrix_counter = 0;
-  int tile_counter = 0;
+  double *B = malloc((size_t)A.m * A.n * sizeof(double));
 
-  for (int i = 0; i < A.matrix_size / A.tile_size; i++)
+  // Gather the tiles in a row major matrix
+  for (int i = 0; i < A.mt; i++)
   {
-    for (int j = 0; j < A.matrix_size / A.tile_size; j++)
+    for (int j = 0; j < A.nt; j++)
     {
       double *dA = A(i, j);
-      for (int k = 0; k < A.tile_size; k++)
+      for (int k = 0; k < tpm_tile_cols(A, j); k++)
       {
-        for (int l = 0; l < A.tile_size; l++)
+        for (int l = 0; l < tpm_tile_rows(A, i); l++)
         {
-          B[k * A.matrix_size + l + A.tile_size * j * A.matrix_size +
-            i * A.tile_size] = dA[k * A.tile_size + l];
+          B[(i * A.tile_size + l) * A.n + j * A.tile_size + k] =
+              dA[k * A.tile_ld + l];
         }
       }
-      tile_counter += A.tile_size;
     }
-    matrix_counter += A.matrix_size;
   }
-  for (int i = 0; i < A.matrix_size * A.matrix_size; i++)
+  for (int i = 0; i < A.m * A.n; i++)
   {
     printf("%f ", B[i]);
-    if ((i + 1) % A.matrix_size == 0)
+    if ((i + 1) % A.n == 0)
       printf("\n");
   }
+  free(B);
 }
 
 void tpm_simple_print_matrix(tpm_desc A)
 {
-  int counter = 0;
-  for (int i = 0; i < A.matrix_size / A.tile_size; i++)
+  for (int i = 0; i < A.mt; i++)
   {
-    for (int j = 0; j < A.matrix_size / A.tile_size; j++)
+    for (int j = 0; j < A.nt; j++)
     {
       printf("i, j: %d, %d\n", i, j);
       double *dA = A(i, j);
-      for (int k = 0; k < A.tile_size; k++)
+      for (int k = 0; k < tpm_tile_cols(A, j); k++)
       {
-        for (int l = 0; l < A.tile_size; l++)
+        for (int l = 0; l < tpm_tile_rows(A, i); l++)
         {
-          printf("%f ", dA[k * A.tile_size + l]);
+          printf("%f ", dA[k * A.tile_ld + l]);
         }
         printf("\n");
       }
       printf("\n");
-      counter++;
     }
   }
 }
@@ -0,0 +1,321 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  roofline.h
+ *
+ *    Description:  Operation and memory traffic model of the algorithms, per task type
+ *
+ *        Version:  1.0
+ *        Created:  19/10/2026
+ *       Revision:  none
+ *       Compiler:  clang
+ *
+ *         Author:  Idriss Daoudi <idaoudi@anl.gov>
+ *   Organization:  Argonne National Laboratory
+ *
+ * =====================================================================================
+ */
+
+// Work of the tasks of one type, over a run of an algorithm. The bytes are
+// the tiles each task reads plus the ones it writes (both for an inout), the
+// compulsory traffic of the task, not what the caches make of it
+typedef struct
+{
+  long count;
+  double flops;
+  double bytes;
+} tpm_work;
+
+tpm_work tpm_works[TPM_TASK_TYPES];
+
+// Forget the model and the measured times, keeping nothing registered
+void tpm_work_reset()
+{
+  tpm_task_types = 0;
+  memset(tpm_works, 0, sizeof(tpm_works));
+  memset(tpm_task_times, 0, sizeof(tpm_task_times));
+}
+
+// Add a task to the model, with the number of elements it reads and writes,
+// registering its type for the timing on the first one
+static void tpm_work_add(const char *name, double flops, double read,
+                         double written)
+{
+  int t = tpm_task_type(name);
+  if (t < 0)
+  {
+    if (tpm_task_types == TPM_TASK_TYPES)
+      return;
+    t = tpm_task_types++;
+    snprintf(tpm_task_names[t], TPM_STRING_SIZE, "%s", name);
+  }
+  tpm_works[t].count++;
+  tpm_works[t].flops += flops;
+  tpm_works[t].bytes += (read + written) * sizeof(double);
+}
+
+// The models follow the task graphs of the algorithms, tile by tile
+
+void tpm_cholesky_work(int matrix_size, int tile_size)
+{
+  tpm_desc A = tpm_matrix_desc_init(tile_size, matrix_size, matrix_size);
+  for (int k = 0; k < A.nt; k++)
+  {
+    double kk = tpm_tile_cols(A, k);
+    tpm_work_add("potrf", tpm_flops_potrf(kk), kk * kk, kk * kk);
+    for (int m = k + 1; m < A.nt; m++)
+    {
+      double mm = tpm_tile_cols(A, m);
+      tpm_work_add("trsm", tpm_flops_trsm(kk, mm), kk * kk + kk * mm, kk * mm);
+    }
+    for (int m = k + 1; m < A.nt; m++)
+    {
+      double mm = tpm_tile_cols(A, m);
+      tpm_work_add("syrk", tpm_flops_syrk(mm, kk), kk * mm + mm * mm, mm * mm);
+      for (int n = k + 1; n < m; n++)
+      {
+        double nn = tpm_tile_cols(A, n);
+        tpm_work_add("gemm", tpm_flops_gemm(nn, mm, kk),
+                     kk * nn + kk * mm + nn * mm, nn * mm);
+      }
+    }
+  }
+}
+
+// Binary tree reduction of the panels, the reflectors of ttqrt being as
+// long as their column in the triangles
+static void tpm_qr_tree_work(tpm_desc A, double ib)
+{
+  for (int k = 0; k < min(A.mt, A.nt); k++)
+  {
+    double kn = tpm_tile_cols(A, k);
+    for (int m = k; m < A.mt; m++)
+    {
+      double mm = tpm_tile_rows(A, m);
+      tpm_work_add("geqrt", tpm_flops_geqrf(mm, kn), mm * kn,
+                   mm * kn + ib * kn);
+      for (int n = k + 1; n < A.nt; n++)
+      {
+        double nn = tpm_tile_cols(A, n);
+        tpm_work_add("ormqr", tpm_flops_ormqr(mm, nn, min(mm, kn)),
+                     mm * kn + ib * kn + mm * nn, mm * nn);
+      }
+    }
+    for (int step = 1; k + step < A.mt; step *= 2)
+    {
+      for (int m = k; m + step < A.mt; m += 2 * step)
+      {
+        double mm = tpm_tile_rows(A, m + step);
+        tpm_work_add("ttqrt", tpm_flops_ttqrt(kn), kn * kn + mm * kn,
+                     kn * kn + mm * kn + ib * kn);
+        for (int n = k + 1; n < A.nt; n++)
+        {
+          double nn = tpm_tile_cols(A, n);
+          tpm_work_add("ttmqr", tpm_flops_ttmqr(nn, kn),
+                       kn * nn + mm * nn + mm * kn + ib * kn,
+                       kn * nn + mm * nn);
+        }
+      }
+    }
+  }
+}
+
+// The T factors (ib rows) are counted as traffic, not as operations
+void tpm_qr_work(int m_size, int n_size, int tile_size, double ib)
+{
+  tpm_desc A = tpm_matrix_desc_init(tile_size, m_size, n_size);
+  if (QR_TREE)
+  {
+    tpm_qr_tree_work(A, ib);
+    return;
+  }
+  for (int k = 0; k < min(A.mt, A.nt); k++)
+  {
+    double km = tpm_tile_rows(A, k);
+    double kn = tpm_tile_cols(A, k);
+    tpm_work_add("geqrt", tpm_flops_geqrf(km, kn), km * kn,
+                 km * kn + ib * kn);
+    for (int n = k + 1; n < A.nt; n++)
+    {
+      double nn = tpm_tile_cols(A, n);
+      tpm_work_add("ormqr", tpm_flops_ormqr(km, nn, min(km, kn)),
+                   km * kn + ib * kn + km * nn, km * nn);
+    }
+    for (int m = k + 1; m < A.mt; m++)
+    {
+      double mm = tpm_tile_rows(A, m);
+      tpm_work_add("tsqrt", tpm_flops_tsqrt(mm, kn), kn * kn + mm * kn,
+                   kn * kn + mm * kn + ib * kn);
+      for (int n = k + 1; n < A.nt; n++)
+      {
+        double nn = tpm_tile_cols(A, n);
+        tpm_work_add("tsmqr", tpm_flops_tsmqr(mm, nn, kn),
+                     km * nn + mm * nn + mm * kn + ib * kn, km * nn + mm * nn);
+      }
+    }
+  }
+}
+
+// Each row swap reads and writes two rows of a tile
+void tpm_lu_work(int matrix_size, int tile_size)
+{
+  tpm_desc A = tpm_matrix_desc_init(tile_size, matrix_size, matrix_size);
+  for (int k = 0; k < min(A.mt, A.nt); k++)
+  {
+    double m = A.m - k * tile_size;
+    double kn = tpm_tile_cols(A, k);
+    tpm_work_add("getrfpiv", tpm_flops_getrf(m, kn), m * kn, m * kn);
+    for (int n = 0; n < k; n++)
+    {
+      double swaps = min(m, kn);
+      double nn = tpm_tile_cols(A, n);
+      tpm_work_add("geswp", 0.0, 2.0 * swaps * nn, 2.0 * swaps * nn);
+    }
+    for (int j = k + 1; j < A.nt; j++)
+    {
+      double jn = tpm_tile_cols(A, j);
+      tpm_work_add("trsmswp", tpm_flops_trsm(kn, jn),
+                   kn * kn + kn * jn + 2.0 * kn * jn, kn * jn + 2.0 * kn * jn);
+      for (int i = k + 1; i < A.mt; i++)
+      {
+        double im = tpm_tile_rows(A, i);
+        tpm_work_add("gemm", tpm_flops_gemm(im, jn, kn),
+                     im * kn + kn * jn + im * jn, im * jn);
+      }
+    }
+  }
+}
+
+// The LU factorization, then the inversion of U, the solve with L and the
+// column interchanges, each reading and writing a tile row
+void tpm_invert_work(int matrix_size, int tile_size)
+{
+  tpm_desc A = tpm_matrix_desc_init(tile_size, matrix_size, matrix_size);
+  tpm_lu_work(matrix_size, tile_size);
+  for (int k = 0; k < A.nt; k++)
+  {
+    double kn = tpm_tile_cols(A, k);
+    for (int m = k; m < A.mt; m++)
+    {
+      double mm = tpm_tile_rows(A, m);
+      tpm_work_add("lacpy", 0.0, mm * kn, 2.0 * mm * kn);
+    }
+  }
+  for (int k = 0; k < A.nt; k++)
+  {
+    double kn = tpm_tile_cols(A, k);
+    for (int n = k + 1; n < A.nt; n++)
+    {
+      double nn = tpm_tile_cols(A, n);
+      tpm_work_add("trsm", tpm_flops_trsm(kn, nn), kn * kn + kn * nn, kn * nn);
+      for (int m = 0; m < k; m++)
+      {
+        double mm = tpm_tile_rows(A, m);
+        tpm_work_add("gemm", tpm_flops_gemm(mm, nn, kn),
+                     mm * kn + kn * nn + mm * nn, mm * nn);
+      }
+    }
+    for (int m = 0; m < k; m++)
+    {
+      double mm = tpm_tile_rows(A, m);
+      tpm_work_add("trsm", tpm_flops_trsm(kn, mm), kn * kn + mm * kn, mm * kn);
+    }
+    tpm_work_add("trtri", tpm_flops_trtri(kn), kn * kn, kn * kn);
+  }
+  for (int k = A.nt - 1; k >= 0; k--)
+  {
+    double kn = tpm_tile_cols(A, k);
+    for (int m = 0; m < A.mt; m++)
+    {
+      double mm = tpm_tile_rows(A, m);
+      for (int j = k + 1; j < A.nt; j++)
+      {
+        double jn = tpm_tile_cols(A, j);
+        tpm_work_add("gemm", tpm_flops_gemm(mm, kn, jn),
+                     mm * jn + jn * kn + mm * kn, mm * kn);
+      }
+      tpm_work_add("trsm", tpm_flops_trsm(kn, mm), kn * kn + mm * kn, mm * kn);
+    }
+  }
+  for (int m = 0; m < A.mt; m++)
+  {
+    double mm = tpm_tile_rows(A, m);
+    tpm_work_add("colswp", 0.0, mm * matrix_size, mm * matrix_size);
+  }
+}
+
+// Iterations of tile_size x tile_size problems, batch of them per task
+void tpm_sylsvd_work(int iter, int tile_size, int batch)
+{
+  double b = tile_size;
+  for (int i = 0; i < iter; i += batch)
+  {
+    double p = min(batch, iter - i);
+    tpm_work_add("trsyl", p * tpm_flops_trsyl(b), p * 3.0 * b * b, p * b * b);
+    tpm_work_add("gesvd", p * tpm_flops_gesvd(b), p * b * b, p * (3.0 * b * b + b));
+    tpm_work_add("geev", p * tpm_flops_geev(b), p * b * b, p * (b * b + b));
+    tpm_work_add("gemm", p * tpm_flops_gemm(b, b, b), p * 2.0 * b * b, p * b * b);
+  }
+}
+
+// The fill-in is followed on the structure of the generated matrix, so the
+// bmod tasks of the tiles it creates are counted
+void tpm_sparselu_work(int matrix_size, int tile_size)
+{
+  double b = tile_size;
+  char *nonzero = malloc((size_t)matrix_size * matrix_size);
+  for (int m = 0; m < matrix_size; m++)
+    for (int n = 0; n < matrix_size; n++)
+      nonzero[m * matrix_size + n] = tpm_sparse_nonzero(m, n);
+
+  for (int k = 0; k < matrix_size; k++)
+  {
+    tpm_work_add("lu0", tpm_flops_lu0(b), b * b, b * b);
+    for (int j = k + 1; j < matrix_size; j++)
+      if (nonzero[k * matrix_size + j])
+        tpm_work_add("fwd", tpm_flops_fwd(b), 2.0 * b * b, b * b);
+    for (int i = k + 1; i < matrix_size; i++)
+      if (nonzero[i * matrix_size + k])
+        tpm_work_add("bdiv", tpm_flops_bdiv(b), 2.0 * b * b, b * b);
+    for (int i = k + 1; i < matrix_size; i++)
+      if (nonzero[i * matrix_size + k])
+        for (int j = k + 1; j < matrix_size; j++)
+          if (nonzero[k * matrix_size + j])
+          {
+            nonzero[i * matrix_size + j] = 1;
+            tpm_work_add("bmod", tpm_flops_bmod(b), 3.0 * b * b, b * b);
+          }
+  }
+  free(nonzero);
+}
+
+// Summary of the model and of the measured task times, for runs of the
+// algorithm taking time seconds in total. The rate of a task type is over the
+// time spent in its tasks, summed over the threads, and the one of the total
+// over the elapsed time
+void tpm_roofline_print(const char *algorithm, double time, int runs)
+{
+  double flops = 0.0, bytes = 0.0, task_time = 0.0;
+  long count = 0;
+
+  printf("algorithm,matrix_size,tile_size,task,count,gflop,gbytes,intensity,"
+         "task_time,gflops\n");
+  for (int t = 0; t < tpm_task_types; t++)
+  {
+    tpm_work w = tpm_works[t];
+    w.count *= runs;
+    w.flops *= runs;
+    w.bytes *= runs;
+    printf("%s,%d,%d,%s,%ld,%f,%f,%f,%f,%f\n", algorithm, MSIZE, BSIZE,
+           tpm_task_names[t], w.count, w.flops / 1e9, w.bytes / 1e9,
+           w.bytes > 0 ? w.flops / w.bytes : 0.0, tpm_task_times[t],
+           tpm_task_times[t] > 0 ? w.flops / tpm_task_times[t] / 1e9 : 0.0);
+    count += w.count;
+    flops += w.flops;
+    bytes += w.bytes;
+    task_time += tpm_task_times[t];
+  }
+  printf("%s,%d,%d,total,%ld,%f,%f,%f,%f,%f\n", algorithm, MSIZE, BSIZE, count,
+         flops / 1e9, bytes / 1e9, bytes > 0 ? flops / bytes : 0.0, task_time,
+         time > 0 ? flops / time / 1e9 : 0.0);
+}
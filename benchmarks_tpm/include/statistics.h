@@ -0,0 +1,62 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  statistics.h
+ *
+ *    Description:  Statistics over the repetitions of a run
+ *
+ *        Version:  1.0
+ *        Created:  19/10/2026
+ *       Revision:  none
+ *       Compiler:  clang
+ *
+ *         Author:  Idriss Daoudi <idaoudi@anl.gov>
+ *   Organization:  Argonne National Laboratory
+ *
+ * =====================================================================================
+ */
+
+static int tpm_compare_doubles(const void *a, const void *b)
+{
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+// Median of the n values, which are left sorted
+double tpm_median(double *values, int n)
+{
+  qsort(values, n, sizeof(double), tpm_compare_doubles);
+  if (n % 2)
+    return values[n / 2];
+  return (values[n / 2 - 1] + values[n / 2]) / 2.0;
+}
+
+double tpm_minimum(const double *values, int n)
+{
+  double minimum = values[0];
+  for (int i = 1; i < n; i++)
+    minimum = min(minimum, values[i]);
+  return minimum;
+}
+
+double tpm_maximum(const double *values, int n)
+{
+  double maximum = values[0];
+  for (int i = 1; i < n; i++)
+    maximum = max(maximum, values[i]);
+  return maximum;
+}
+
+// Sample standard deviation, 0 for a single value
+double tpm_stddev(const double *values, int n)
+{
+  if (n < 2)
+    return 0.0;
+  double mean = 0.0, sum = 0.0;
+  for (int i = 0; i < n; i++)
+    mean += values[i];
+  mean /= n;
+  for (int i = 0; i < n; i++)
+    sum += (values[i] - mean) * (values[i] - mean);
+  return sqrt(sum / (n - 1));
+}
@@ -21,7 +21,19 @@ inline static void *tpm_tile_address(tpm_desc A, int m, int n)
   size_t single_element_size = sizeof(double);
   size_t offset = 0;
 
-  // Current implementation considers that matrix size % bloc size = 0
-  offset = A.tile_nelements * (m + A.matrix_size / A.tile_size * n);
+  // Tiles stored column after column, all with the full tile stride
+  offset = A.tile_nelements * (m + (size_t)A.mt * n);
   return (void *)((char *)A.matrix + (offset * single_element_size));
 }
+
+// Rows of the tiles of tile row m, fewer on the last one when ragged
+inline static int tpm_tile_rows(tpm_desc A, int m)
+{
+  return m == A.mt - 1 ? A.m - m * A.tile_size : A.tile_size;
+}
+
+// Columns of the tiles of tile column n
+inline static int tpm_tile_cols(tpm_desc A, int n)
+{
+  return n == A.nt - 1 ? A.n - n * A.tile_size : A.tile_size;
+}
@@ -22,12 +22,25 @@
 #include "lapacke.h"
 #include <omp.h>
 
-int MSIZE, BSIZE, NTH, TPM_TRACE, TPM_TRACE, TPM_PAPI;
+int MSIZE, NSIZE, BSIZE, NTH, TPM_TRACE, TPM_TRACE, TPM_PAPI;
 long l3_cache_size;
+// Lookahead depth of the Cholesky priorities, none if < 0
+int LOOKAHEAD = -1;
+// Tasks of Cholesky and QR created from inside the tasks instead of flat
+int NESTED = 0;
+// QR panels reduced by a binary tree of ttqrt instead of the flat tsqrt chain
+int QR_TREE = 0;
+// Inner block size of the QR kernels, the tile size if 0, autotuned if -1
+int QR_IB = 0;
+// Problems of sylsvd handled by each of its tasks
+int SYLSVD_BATCH = 1;
+// Threads factorizing each LU panel together, from TPM_PANEL_THREADS
+int PANEL_THREADS = 1;
 
 #define A(m, n) tpm_tile_address(A, m, n)
 #define B(m, n) tpm_tile_address(B, m, n)
 #define S(m, n) tpm_tile_address(S, m, n)
+#define L(m, n) tpm_tile_address(L, m, n)
 
 #define tpm_upper 121
 #define tpm_lower 122
@@ -49,10 +62,15 @@ long l3_cache_size;
 
 #include "cvector.h"
 #include "descriptor.h"
+#include "flops.h"
+#include "statistics.h"
 #include "tile_address.h"
 #include "populate.h"
+#include "cache.h"
+#include "roofline.h"
 #include "print.h"
 #include "counters.h"
+#include "workspace.h"
 
 #include "cholesky.h"
 
@@ -60,11 +78,14 @@ long l3_cache_size;
 #include "srcqr/dormqr.h"
 #include "srcqr/dtsmqr.h"
 #include "srcqr/dtsqrt.h"
+#include "srcqr/dttmqr.h"
+#include "srcqr/dttqrt.h"
 #include "qr.h"
 
 #include "srclu/lacpy.h"
 #include "srclu/tile_lapacke_conversion.h"
 #include "srclu/geswp.h"
+#include "srclu/getrf_panel.h"
 #include "lu.h"
 
 #include "srcslu/empty_block.h"
@@ -79,4 +100,7 @@ long l3_cache_size;
 
 #include "sylsvd.h"
 
-#include "invert.h"
\ No newline at end of file
+#include "invert.h"
+
+#include "check.h"
+#include "autotune.h"
\ No newline at end of file
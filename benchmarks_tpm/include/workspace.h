@@ -0,0 +1,98 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  workspace.h
+ *
+ *    Description:  Per thread workspaces of the tile kernels
+ *
+ *        Version:  1.0
+ *        Created:  19/10/2026
+ *       Revision:  none
+ *       Compiler:  clang
+ *
+ *         Author:  Idriss Daoudi <idaoudi@anl.gov>
+ *   Organization:  Argonne National Laboratory
+ *
+ * =====================================================================================
+ */
+
+// Scratch space of the kernels: a tile and a vector of tile_size for QR,
+// and the space of the LAPACK routines of the algorithm, if any
+typedef struct
+{
+  double *work;
+  double *tho;
+  double *lapack;
+} tpm_workspace;
+
+tpm_workspace *tpm_workspaces = NULL;
+int tpm_workspace_threads = 0;
+int tpm_workspace_tile_size = 0;
+size_t tpm_workspace_lapack_size = 0;
+
+void tpm_workspace_free()
+{
+  for (int t = 0; t < tpm_workspace_threads; t++)
+  {
+    free(tpm_workspaces[t].work);
+    free(tpm_workspaces[t].tho);
+    free(tpm_workspaces[t].lapack);
+  }
+  free(tpm_workspaces);
+  tpm_workspaces = NULL;
+  tpm_workspace_threads = 0;
+  tpm_workspace_tile_size = 0;
+  tpm_workspace_lapack_size = 0;
+}
+
+// One workspace per thread of the team, allocated and touched by its thread
+// so that its pages are on the NUMA node of the thread, before the run. They
+// are kept from one call to the other, for the same tile size and no more
+// LAPACK space, of lapack_size doubles
+void tpm_workspace_alloc(int tile_size, size_t lapack_size)
+{
+  int threads = omp_get_max_threads();
+  if (tpm_workspace_tile_size == tile_size && tpm_workspace_threads >= threads &&
+      tpm_workspace_lapack_size >= lapack_size)
+    return;
+  tpm_workspace_free();
+
+  int failed = 0;
+  tpm_workspaces = (tpm_workspace *)calloc(threads, sizeof(tpm_workspace));
+  if (tpm_workspaces == NULL)
+    failed = 1;
+  else
+  {
+#pragma omp parallel num_threads(threads) reduction(| : failed)
+    {
+      tpm_workspace *workspace = &tpm_workspaces[omp_get_thread_num()];
+      workspace->work = (double *)malloc((size_t)tile_size * tile_size * sizeof(double));
+      workspace->tho = (double *)malloc((size_t)tile_size * sizeof(double));
+      workspace->lapack = (double *)malloc(max(lapack_size, 1) * sizeof(double));
+      if (workspace->work == NULL || workspace->tho == NULL || workspace->lapack == NULL)
+        failed = 1;
+      else
+      {
+        memset(workspace->work, 0, (size_t)tile_size * tile_size * sizeof(double));
+        memset(workspace->tho, 0, (size_t)tile_size * sizeof(double));
+        memset(workspace->lapack, 0, lapack_size * sizeof(double));
+      }
+    }
+    tpm_workspace_threads = threads;
+    tpm_workspace_tile_size = tile_size;
+    tpm_workspace_lapack_size = lapack_size;
+  }
+  if (failed)
+  {
+    printf("Problem allocating the kernel workspaces.\n");
+    exit(EXIT_FAILURE);
+  }
+}
+
+// Workspace of the calling thread. A task uses it from its start to its
+// finish without a task scheduling point in between, so that no other task
+// of the thread runs meanwhile
+static inline tpm_workspace *tpm_workspace_get()
+{
+  return &tpm_workspaces[omp_get_thread_num()];
+}
@@ -69,33 +69,333 @@ AlgorithmType parse_algorithm(const char *algorithm)
   }
 }
 
-int tpm_allocate_tile(int M, tpm_desc **desc, int B)
+int tpm_allocate_tile(int M, int N, tpm_desc **desc, int B)
 {
-  int MT = M / B;
   *desc = (tpm_desc *)malloc(sizeof(tpm_desc));
   if (*desc == NULL)
   {
     printf("Tile allocation failed.\n");
     return 1;
   }
-  **desc = tpm_matrix_desc_init(B, MT * B, B * B, MT * B);
+  **desc = tpm_matrix_desc_init(B, M, N);
   int info = tpm_matrix_desc_alloc(*desc);
   assert(!info);
   return 0;
 }
 
+// Cholesky and QR of the run, with the flat or the nested task graph
+void tpm_cholesky(tpm_desc A)
+{
+  if (NESTED)
+    cholesky_nested(A);
+  else
+    cholesky(A, LOOKAHEAD);
+}
+
+void tpm_qr(tpm_desc A, tpm_desc S)
+{
+  if (NESTED)
+    qr_nested(A, S);
+  else if (QR_TREE)
+    qr_tree(A, S);
+  else
+    qr(A, S);
+}
+
+// Triangular factors of QR, of QR_IB rows used out of the tiles, with a
+// second set of tile rows under the first one for the ttqrt of the tree
+// reduction, and the workspaces of the threads for its kernels
+int tpm_allocate_factors(tpm_desc **S)
+{
+  int rows = MSIZE;
+  if (QR_TREE)
+    rows = 2 * ((MSIZE + BSIZE - 1) / BSIZE) * BSIZE;
+  tpm_workspace_alloc(BSIZE, 0);
+  int error = tpm_allocate_tile(rows, NSIZE, S, BSIZE);
+  if (!error)
+    (*S)->ib = QR_IB;
+  return error;
+}
+
+// Model of the tasks of the algorithm, and timing of the tasks, for the
+// roofline summary of the run
+void tpm_roofline_start(AlgorithmType algo_type)
+{
+  tpm_work_reset();
+  switch (algo_type)
+  {
+  case ALGO_CHOLESKY:
+    tpm_cholesky_work(MSIZE, BSIZE);
+    break;
+  case ALGO_QR:
+    tpm_qr_work(MSIZE, NSIZE, BSIZE, QR_IB);
+    break;
+  case ALGO_LU:
+    tpm_lu_work(MSIZE, BSIZE);
+    break;
+  case ALGO_SPARSELU:
+    tpm_sparselu_work(MSIZE, BSIZE);
+    break;
+  case ALGO_SYLSVD:
+    tpm_sylsvd_work(MSIZE / BSIZE, BSIZE, SYLSVD_BATCH);
+    break;
+  case ALGO_INVERT:
+    tpm_invert_work(MSIZE, BSIZE);
+    break;
+  default:
+    break;
+  }
+  tpm_task_timing = 1;
+}
+
+// Layout sweep: factorize the same problem with every tile layout and page
+// size combination, untraced, and report the achieved GFLOP/s
+void tpm_layout_sweep(AlgorithmType algo_type, const char *algorithm)
+{
+  int pads[] = {0, 8};
+  int aligns[] = {64, 4096};
+  int hugepages[] = {0, 1, 2};
+  int pad = TPM_TILE_PAD, align = TPM_TILE_ALIGN, huge = TPM_HUGEPAGES;
+
+  printf("algorithm,matrix_size,tile_size,tile_ld,tile_align,hugepages,numa_nodes,time,gflops\n");
+  for (int p = 0; p < sizeof(pads) / sizeof(pads[0]); p++)
+  {
+    for (int a = 0; a < sizeof(aligns) / sizeof(aligns[0]); a++)
+    {
+      for (int h = 0; h < sizeof(hugepages) / sizeof(hugepages[0]); h++)
+      {
+        TPM_TILE_PAD = pads[p];
+        TPM_TILE_ALIGN = aligns[a];
+        TPM_HUGEPAGES = hugepages[h];
+
+        tpm_desc *A = NULL;
+        tpm_desc *S = NULL;
+        int ret = tpm_allocate_tile(MSIZE, NSIZE, &A, BSIZE);
+        assert(ret == 0);
+        tpm_cached_generator(*A, "hermitian", tpm_hermitian_positive_generator);
+        double flops;
+        if (algo_type == ALGO_QR)
+        {
+          ret = tpm_allocate_factors(&S);
+          assert(ret == 0);
+          flops = tpm_flops_geqrf(MSIZE, NSIZE);
+        }
+        else
+        {
+          flops = tpm_flops_potrf(MSIZE);
+        }
+
+        time_start = omp_get_wtime();
+#pragma omp parallel
+#pragma omp master
+        {
+          if (algo_type == ALGO_QR)
+            tpm_qr(*A, *S);
+          else
+            tpm_cholesky(*A);
+        }
+        time_finish = omp_get_wtime();
+
+        printf("%s,%d,%d,%d,%d,%d,%d,%f,%f\n", algorithm, MSIZE, BSIZE, A->tile_ld,
+               TPM_TILE_ALIGN, A->hugepages, A->numa_nodes, time_finish - time_start,
+               flops / (time_finish - time_start) / 1e9);
+
+        if (S)
+        {
+          tpm_matrix_desc_free(S);
+          tpm_matrix_desc_destroy(&S);
+        }
+        tpm_matrix_desc_free(A);
+        tpm_matrix_desc_destroy(&A);
+      }
+    }
+  }
+  TPM_TILE_PAD = pad;
+  TPM_TILE_ALIGN = align;
+  TPM_HUGEPAGES = huge;
+}
+
+// Repetitions of the same factorization, on the same input regenerated in
+// place before each one. The warmup repetitions are not measured, the others
+// each run in their own energy window, and are followed by their median,
+// minimum and standard deviation, and by the roofline summary of the
+// measured ones if asked. With check, the result of the last one is verified,
+// and 1 returned if wrong
+int tpm_repeat(AlgorithmType algo_type, const char *algorithm, int repeat,
+               int warmup, int roofline, int check)
+{
+  tpm_desc *A = NULL;
+  tpm_desc *S = NULL;
+  double *A0 = NULL;
+  int *ipiv = NULL;
+  double flops;
+  int failed = 0;
+
+  int error = tpm_allocate_tile(MSIZE, NSIZE, &A, BSIZE);
+  switch (algo_type)
+  {
+  case ALGO_QR:
+    error |= tpm_allocate_factors(&S);
+    flops = tpm_flops_geqrf(MSIZE, NSIZE);
+    break;
+  case ALGO_LU:
+  case ALGO_INVERT:
+    ipiv = malloc(MSIZE * sizeof(int));
+    error |= ipiv == NULL;
+    flops = tpm_flops_getrf(MSIZE, NSIZE);
+    if (algo_type == ALGO_INVERT)
+      flops += tpm_flops_getri(MSIZE);
+    break;
+  default:
+    flops = tpm_flops_potrf(MSIZE);
+  }
+  if (error)
+  {
+    printf("Problem allocating contiguous memory.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  double *times = malloc(repeat * sizeof(double));
+  double *gflops = malloc(repeat * sizeof(double));
+  double measured = 0.0;
+
+  printf("algorithm,matrix_size,tile_size,repetition,time,gflops\n");
+  TPM_application_start();
+  for (int r = -warmup; r < repeat; r++)
+  {
+    if (algo_type == ALGO_LU || algo_type == ALGO_INVERT)
+      tpm_cached_generator(*A, "dense", tpm_dense_tile_generator);
+    else
+      tpm_cached_generator(*A, "hermitian", tpm_hermitian_positive_generator);
+    if (check && A0 == NULL)
+      A0 = tpm_check_copy(*A);
+
+    // Task times of the measured repetitions only
+    if (r == 0 && roofline)
+      memset(tpm_task_times, 0, sizeof(tpm_task_times));
+    if (r >= 0)
+      TPM_application_energy(1);
+    time_start = omp_get_wtime();
+#pragma omp parallel
+#pragma omp master
+    {
+      switch (algo_type)
+      {
+      case ALGO_QR:
+        tpm_qr(*A, *S);
+        break;
+      case ALGO_LU:
+        lu(*A, ipiv);
+        break;
+      case ALGO_INVERT:
+        invert(*A, ipiv);
+        break;
+      default:
+        tpm_cholesky(*A);
+      }
+    }
+    time_finish = omp_get_wtime();
+    if (r < 0)
+      continue;
+    TPM_application_energy(0);
+
+    times[r] = time_finish - time_start;
+    gflops[r] = flops / times[r] / 1e9;
+    measured += times[r];
+    printf("%s,%d,%d,%d,%f,%f\n", algorithm, MSIZE, BSIZE, r, times[r], gflops[r]);
+  }
+  TPM_application_finalize(measured);
+
+  // The rate of the fastest repetition on the min row
+  printf("%s,%d,%d,median,%f,%f\n", algorithm, MSIZE, BSIZE,
+         tpm_median(times, repeat), tpm_median(gflops, repeat));
+  printf("%s,%d,%d,min,%f,%f\n", algorithm, MSIZE, BSIZE,
+         tpm_minimum(times, repeat), tpm_maximum(gflops, repeat));
+  printf("%s,%d,%d,stddev,%f,%f\n", algorithm, MSIZE, BSIZE,
+         tpm_stddev(times, repeat), tpm_stddev(gflops, repeat));
+  if (roofline)
+    tpm_roofline_print(algorithm, measured, repeat);
+
+  if (check)
+  {
+    switch (algo_type)
+    {
+    case ALGO_QR:
+      failed = tpm_check_report(algorithm, tpm_check_qr(*A, *S, A0));
+      break;
+    case ALGO_LU:
+      failed = tpm_check_report(algorithm, tpm_check_lu(*A, ipiv, A0));
+      break;
+    case ALGO_INVERT:
+      failed = tpm_check_report(algorithm, tpm_check_invert(*A, A0));
+      break;
+    default:
+      failed = tpm_check_report(algorithm, tpm_check_cholesky(*A, A0));
+    }
+  }
+
+  free(A0);
+  free(times);
+  free(gflops);
+  free(ipiv);
+  if (S)
+  {
+    tpm_matrix_desc_free(S);
+    tpm_matrix_desc_destroy(&S);
+  }
+  tpm_matrix_desc_free(A);
+  tpm_matrix_desc_destroy(&A);
+  return failed;
+}
+
 int main(int argc, char *argv[])
 {
   NTH = atoi(getenv("TPM_THREADS"));
   TPM_TRACE = atoi(getenv("TPM_POWER_SET"));
   TPM_PAPI = atoi(getenv("TPM_PAPI_SET"));
+  if (getenv("TPM_NUMA"))
+    TPM_NUMA = atoi(getenv("TPM_NUMA"));
+  if (getenv("TPM_HUGEPAGES"))
+    TPM_HUGEPAGES = atoi(getenv("TPM_HUGEPAGES"));
+  if (getenv("TPM_TILE_PAD"))
+    TPM_TILE_PAD = atoi(getenv("TPM_TILE_PAD"));
+  if (getenv("TPM_TILE_ALIGN"))
+    TPM_TILE_ALIGN = atoi(getenv("TPM_TILE_ALIGN"));
+  TPM_MATRIX_CACHE = getenv("TPM_MATRIX_CACHE");
+  if (getenv("TPM_PANEL_THREADS"))
+    PANEL_THREADS = atoi(getenv("TPM_PANEL_THREADS"));
+  // The LU panel threads are a team nested in the one of the algorithm
+  if (PANEL_THREADS > 1)
+    omp_set_max_active_levels(2);
+  if (TPM_TILE_PAD < 0 || TPM_TILE_ALIGN < 8 || TPM_TILE_ALIGN % 8 != 0)
+  {
+    printf("Invalid tile padding or alignment. Aborting.\n");
+    exit(EXIT_FAILURE);
+  }
 
   // Command line arguments parsing
   int arguments = 0;
   char algorithm[16];
+  int layouts = 0;
+  int seeded = 0;
+  int repeat = 0, warmup = 0;
+  int roofline = 0;
+  int check = 0, failed = 0;
   struct option long_options[] = {{"Algorithm", required_argument, NULL, 'a'},
                                   {"Matrix size", required_argument, NULL, 'm'},
+                                  {"Matrix columns", required_argument, NULL, 'n'},
                                   {"Tile size", required_argument, NULL, 'b'},
+                                  {"layouts", no_argument, NULL, 'l'},
+                                  {"seed", required_argument, NULL, 's'},
+                                  {"repeat", required_argument, NULL, 'r'},
+                                  {"warmup", required_argument, NULL, 'w'},
+                                  {"flops", no_argument, NULL, 'f'},
+                                  {"check", no_argument, NULL, 'c'},
+                                  {"lookahead", required_argument, NULL, 'k'},
+                                  {"dag", required_argument, NULL, 'd'},
+                                  {"tree", required_argument, NULL, 't'},
+                                  {"ib", required_argument, NULL, 'i'},
+                                  {"batch", required_argument, NULL, 'g'},
                                   {NULL, no_argument, NULL, 0}};
 
   if (argc < 2)
@@ -107,7 +407,7 @@ int main(int argc, char *argv[])
   AlgorithmType algo_type = ALGO_UNKNOWN;
 
   while ((arguments =
-              getopt_long(argc, argv, "a:m:b:h:", long_options, NULL)) != -1)
+              getopt_long(argc, argv, "a:m:n:b:h:ls:r:w:fck:d:t:i:g:", long_options, NULL)) != -1)
   {
     if (optind > 2)
     {
@@ -117,6 +417,7 @@ int main(int argc, char *argv[])
         if (optarg)
         {
           algo_type = parse_algorithm(optarg);
+          snprintf(algorithm, sizeof(algorithm), "%s", optarg);
           if (algo_type == ALGO_UNKNOWN)
           {
             printf("Invalid algorithm. Aborting.\n");
@@ -128,10 +429,88 @@ int main(int argc, char *argv[])
         if (optarg)
           MSIZE = atoi(optarg);
         break;
+      case 'n':
+        if (optarg)
+          NSIZE = atoi(optarg);
+        break;
       case 'b':
         if (optarg)
           BSIZE = atoi(optarg);
         break;
+      case 'l':
+        layouts = 1;
+        break;
+      case 's':
+        if (optarg)
+        {
+          tpm_seed = strtoull(optarg, NULL, 10);
+          seeded = 1;
+        }
+        break;
+      case 'r':
+        if (optarg)
+          repeat = atoi(optarg);
+        break;
+      case 'w':
+        if (optarg)
+          warmup = atoi(optarg);
+        break;
+      case 'f':
+        roofline = 1;
+        break;
+      case 'c':
+        check = 1;
+        break;
+      case 'k':
+        if (optarg)
+          LOOKAHEAD = atoi(optarg);
+        break;
+      case 'd':
+        if (optarg)
+        {
+          if (strcmp(optarg, "nested") == 0)
+            NESTED = 1;
+          else if (strcmp(optarg, "flat") != 0)
+          {
+            printf("Invalid task graph, flat or nested. Aborting.\n");
+            exit(EXIT_FAILURE);
+          }
+        }
+        break;
+      case 't':
+        if (optarg)
+        {
+          if (strcmp(optarg, "binary") == 0)
+            QR_TREE = 1;
+          else if (strcmp(optarg, "flat") != 0)
+          {
+            printf("Invalid reduction tree, flat or binary. Aborting.\n");
+            exit(EXIT_FAILURE);
+          }
+        }
+        break;
+      case 'i':
+        if (optarg)
+        {
+          QR_IB = strcmp(optarg, "auto") == 0 ? -1 : atoi(optarg);
+          if (QR_IB == 0 || QR_IB < -1)
+          {
+            printf("Invalid inner block size, a positive number or auto. Aborting.\n");
+            exit(EXIT_FAILURE);
+          }
+        }
+        break;
+      case 'g':
+        if (optarg)
+        {
+          SYLSVD_BATCH = atoi(optarg);
+          if (SYLSVD_BATCH < 1)
+          {
+            printf("Invalid batch size. Aborting.\n");
+            exit(EXIT_FAILURE);
+          }
+        }
+        break;
       case 'h':
         printf("HELP\n");
         exit(EXIT_FAILURE);
@@ -142,16 +521,87 @@ int main(int argc, char *argv[])
     }
   }
 
-  // Check matrix size divisibility by tile size
-  if (algo_type != ALGO_SYLSVD && algo_type != ALGO_SPARSELU)
+  // Same matrices from one run to the other only with a fixed seed
+  if (!seeded)
+    tpm_seed = (uint64_t)time(NULL);
+  if (!seeded && TPM_MATRIX_CACHE)
   {
-    if (MSIZE % BSIZE != 0)
-    {
-      printf("Tile size does not divide the matrix size. Aborting.\n");
-      exit(EXIT_FAILURE);
-    }
+    printf("The matrix cache needs a fixed seed, not used.\n");
+    TPM_MATRIX_CACHE = NULL;
   }
 
+  // Square matrices unless the columns are given, only QR factorizes
+  // rectangular ones
+  if (NSIZE == 0)
+    NSIZE = MSIZE;
+  if (MSIZE <= 0 || BSIZE <= 0 || NSIZE <= 0)
+  {
+    printf("Invalid matrix or tile size. Aborting.\n");
+    exit(EXIT_FAILURE);
+  }
+  if (NSIZE != MSIZE && algo_type != ALGO_QR)
+  {
+    printf("Rectangular matrices only available for qr. Aborting.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  // The priorities are hints, ignored above the maximum of the runtime
+  if (LOOKAHEAD >= 0 && algo_type != ALGO_CHOLESKY)
+  {
+    printf("Lookahead only available for cholesky. Aborting.\n");
+    exit(EXIT_FAILURE);
+  }
+  if (NESTED && LOOKAHEAD >= 0)
+  {
+    printf("Lookahead only available with the flat task graph. Aborting.\n");
+    exit(EXIT_FAILURE);
+  }
+  if (NESTED && algo_type != ALGO_CHOLESKY && algo_type != ALGO_QR)
+  {
+    printf("Nested task graph only available for cholesky and qr. Aborting.\n");
+    exit(EXIT_FAILURE);
+  }
+  if (QR_TREE && (algo_type != ALGO_QR || NESTED))
+  {
+    printf("Reduction tree only available for qr, with the flat task graph. Aborting.\n");
+    exit(EXIT_FAILURE);
+  }
+  if (QR_IB != 0 && algo_type != ALGO_QR)
+  {
+    printf("Inner block size only available for qr. Aborting.\n");
+    exit(EXIT_FAILURE);
+  }
+  if (SYLSVD_BATCH > 1 && algo_type != ALGO_SYLSVD)
+  {
+    printf("Batches only available for sylsvd. Aborting.\n");
+    exit(EXIT_FAILURE);
+  }
+  if (QR_IB > BSIZE)
+  {
+    printf("Inner block size larger than the tile size. Aborting.\n");
+    exit(EXIT_FAILURE);
+  }
+  if (LOOKAHEAD >= 0 && omp_get_max_task_priority() < LOOKAHEAD + 1)
+    printf("Task priorities up to %d need OMP_MAX_TASK_PRIORITY=%d.\n",
+           LOOKAHEAD + 1, LOOKAHEAD + 1);
+
+  // Residual checks of the factorizations only
+  if (check && (algo_type == ALGO_SYLSVD || algo_type == ALGO_POISSON))
+  {
+    printf("Check only available for cholesky, qr, lu, invert and sparselu. Aborting.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  // Inner block size of the QR kernels, the tile size unless given or
+  // autotuned for the tile size
+  if (QR_IB == -1)
+  {
+    QR_IB = tpm_autotune_ib(BSIZE);
+    printf("Inner block size %d autotuned for the tile size %d.\n", QR_IB, BSIZE);
+  }
+  else if (QR_IB == 0)
+    QR_IB = BSIZE;
+
   // PAPI library initialization
   int papi_version = PAPI_library_init(PAPI_VER_CURRENT);
   if (papi_version != PAPI_VER_CURRENT && papi_version > 0)
@@ -191,6 +641,42 @@ int main(int argc, char *argv[])
   int error, ret;
   double time_start, time_finish;
 
+  // Layout sweep mode, for the tile based dense algorithms
+  if (layouts)
+  {
+    if (algo_type != ALGO_CHOLESKY && algo_type != ALGO_QR)
+    {
+      printf("Layout sweep only available for cholesky and qr. Aborting.\n");
+      exit(EXIT_FAILURE);
+    }
+    tpm_layout_sweep(algo_type, algorithm);
+    return 0;
+  }
+
+  // Repeated runs in a single process, for the tile based dense algorithms
+  if (repeat > 0 || warmup > 0)
+  {
+    if (algo_type != ALGO_CHOLESKY && algo_type != ALGO_QR && algo_type != ALGO_LU &&
+        algo_type != ALGO_INVERT)
+    {
+      printf("Repetitions only available for cholesky, qr, lu and invert. Aborting.\n");
+      exit(EXIT_FAILURE);
+    }
+    if (repeat <= 0 || warmup < 0)
+    {
+      printf("Invalid number of repetitions. Aborting.\n");
+      exit(EXIT_FAILURE);
+    }
+    if (roofline)
+      tpm_roofline_start(algo_type);
+    failed = tpm_repeat(algo_type, algorithm, repeat, warmup, roofline, check);
+    return failed ? EXIT_FAILURE : 0;
+  }
+
+  // Operations and traffic of the run, with the time of its tasks
+  if (roofline)
+    tpm_roofline_start(algo_type);
+
   // Launch algorithms
   switch (algo_type)
   {
@@ -199,17 +685,18 @@ int main(int argc, char *argv[])
   case ALGO_QR:
   {
     tpm_desc *A = NULL;
-    double *ptr = NULL;
     tpm_desc *S = NULL;
 
-    error = posix_memalign((void **)&ptr, getpagesize(), MSIZE * MSIZE * sizeof(double));
+    // Tiles placed on the NUMA nodes by a parallel first touch
+    error = tpm_allocate_tile(MSIZE, NSIZE, &A, BSIZE);
     if (error)
     {
       printf("Problem allocating contiguous memory.\n");
       exit(EXIT_FAILURE);
     }
-    tpm_matrix_desc_create(&A, ptr, BSIZE, MSIZE * MSIZE, BSIZE * BSIZE, MSIZE);
-    tpm_hermitian_positive_generator(*A);
+    tpm_cached_generator(*A, "hermitian", tpm_hermitian_positive_generator);
+    // Input kept for the residual check
+    double *A0 = check ? tpm_check_copy(*A) : NULL;
 
     switch (algo_type)
     {
@@ -221,16 +708,19 @@ int main(int argc, char *argv[])
 #pragma omp parallel
 #pragma omp master
       {
-        cholesky(*A);
+        tpm_cholesky(*A);
       }
       time_finish = omp_get_wtime();
       TPM_application_finalize(time_finish - time_start);
+
+      if (check)
+        failed = tpm_check_report(algorithm, tpm_check_cholesky(*A, A0));
       break;
 
     // QR algorithm
     case ALGO_QR:
       // Workspace allocation for QR
-      ret = tpm_allocate_tile(MSIZE, &S, BSIZE);
+      ret = tpm_allocate_factors(&S);
       assert(ret == 0);
 
       TPM_application_start();
@@ -238,29 +728,40 @@ int main(int argc, char *argv[])
 #pragma omp parallel
 #pragma omp master
       {
-        qr(*A, *S);
+        tpm_qr(*A, *S);
       }
       time_finish = omp_get_wtime();
       TPM_application_finalize(time_finish - time_start);
 
-      free(S->matrix);
+      if (check)
+        failed = tpm_check_report(algorithm, tpm_check_qr(*A, *S, A0));
+
+      tpm_matrix_desc_free(S);
       tpm_matrix_desc_destroy(&S);
     }
 
-    free(A->matrix);
+    free(A0);
+    tpm_matrix_desc_free(A);
     tpm_matrix_desc_destroy(&A);
     break;
   }
   // LU algorithm
   case ALGO_LU:
   {
-    double *A = malloc(MSIZE * MSIZE * sizeof(double));
-    double *hA = malloc(MSIZE * MSIZE * sizeof(double));
+    tpm_desc *hA = NULL;
     int *ipiv = malloc(MSIZE * sizeof(int));
 
-    tpm_dense_generator(A, MSIZE);
-    tpm_matrix_to_tile(hA, A, MSIZE, MSIZE, BSIZE, MSIZE);
+    error = tpm_allocate_tile(MSIZE, MSIZE, &hA, BSIZE);
+    if (error || ipiv == NULL)
+    {
+      printf("Problem allocating contiguous memory.\n");
+      exit(EXIT_FAILURE);
+    }
+    tpm_cached_generator(*hA, "dense", tpm_dense_tile_generator);
+    double *A0 = check ? tpm_check_copy(*hA) : NULL;
 #ifdef LOG
+    double *A = malloc((size_t)MSIZE * MSIZE * sizeof(double));
+    tpm_tile_to_matrix(*hA, 0, 0, hA->mt, hA->nt, A, MSIZE);
     tpm_default_print_matrix("A", A, MSIZE);
 #endif
     for (int i = 0; i < MSIZE; i++)
@@ -273,19 +774,24 @@ int main(int argc, char *argv[])
 #pragma omp parallel
 #pragma omp master
     {
-      lu(MSIZE, BSIZE, A, ipiv, hA);
+      lu(*hA, ipiv);
     }
     time_finish = omp_get_wtime();
     TPM_application_finalize(time_finish - time_start);
 
-    tpm_matrix_to_tile(hA, A, MSIZE, MSIZE, BSIZE, MSIZE);
+    if (check)
+      failed = tpm_check_report(algorithm, tpm_check_lu(*hA, ipiv, A0));
+
 #ifdef LOG
+    tpm_tile_to_matrix(*hA, 0, 0, hA->mt, hA->nt, A, MSIZE);
     tpm_default_print_matrix("A", A, MSIZE);
+    free(A);
 #endif
 
-    free(A);
-    free(hA);
+    free(A0);
     free(ipiv);
+    tpm_matrix_desc_free(hA);
+    tpm_matrix_desc_destroy(&hA);
     break;
   }
   // Sylvester-SVD algorithm
@@ -313,17 +819,19 @@ int main(int argc, char *argv[])
       EVs[i] = (double *)calloc(BSIZE, sizeof(double));
       Ms[i] = (double *)calloc(BSIZE * BSIZE, sizeof(double));
 
-      tpm_dense_generator(As[i], BSIZE);
-      tpm_dense_generator(Bs[i], BSIZE);
-      tpm_dense_generator(Xs[i], BSIZE);
+      tpm_dense_generator(As[i], BSIZE, 3 * i);
+      tpm_dense_generator(Bs[i], BSIZE, 3 * i + 1);
+      tpm_dense_generator(Xs[i], BSIZE, 3 * i + 2);
     }
+    // LAPACK space of the threads, allocated once before the run
+    tpm_workspace_alloc(BSIZE, sylsvd_workspace_size(BSIZE));
 
     TPM_application_start();
     time_start = omp_get_wtime();
 #pragma omp parallel
 #pragma omp master
     {
-      sylsvd(As, Bs, Xs, Us, Ss, VTs, EVs, Ms, BSIZE, iter);
+      sylsvd(As, Bs, Xs, Us, Ss, VTs, EVs, Ms, BSIZE, iter, SYLSVD_BATCH);
     }
     time_finish = omp_get_wtime();
     TPM_application_finalize(time_finish - time_start);
@@ -343,23 +851,36 @@ int main(int argc, char *argv[])
   }
   case ALGO_INVERT:
   {
-    double *A = malloc(MSIZE * MSIZE * sizeof(double));
+    tpm_desc *hA = NULL;
     // Partial pivoting index array
     int *ipiv = malloc(MSIZE * sizeof(int));
-    tpm_dense_generator(A, MSIZE);
+
+    error = tpm_allocate_tile(MSIZE, MSIZE, &hA, BSIZE);
+    if (error || ipiv == NULL)
+    {
+      printf("Problem allocating contiguous memory.\n");
+      exit(EXIT_FAILURE);
+    }
+    tpm_cached_generator(*hA, "dense", tpm_dense_tile_generator);
+    double *A0 = check ? tpm_check_copy(*hA) : NULL;
 
     TPM_application_start();
     time_start = omp_get_wtime();
 #pragma omp parallel
 #pragma omp master
     {
-      invert(A, ipiv, MSIZE, BSIZE);
+      invert(*hA, ipiv);
     }
     time_finish = omp_get_wtime();
     TPM_application_finalize(time_finish - time_start);
 
-    free(A);
+    if (check)
+      failed = tpm_check_report(algorithm, tpm_check_invert(*hA, A0));
+
+    free(A0);
     free(ipiv);
+    tpm_matrix_desc_free(hA);
+    tpm_matrix_desc_destroy(&hA);
     break;
   }
 
@@ -390,6 +911,9 @@ int main(int argc, char *argv[])
     time_finish = omp_get_wtime();
     TPM_application_finalize(time_finish - time_start);
 
+    if (check)
+      failed = tpm_check_report(algorithm, tpm_check_sparselu(M, MSIZE, BSIZE));
+
     free(M);
     break;
   }
@@ -398,4 +922,8 @@ int main(int argc, char *argv[])
     printf("Invalid algorithm. Aborting.\n");
     exit(EXIT_FAILURE);
   }
+
+  if (roofline)
+    tpm_roofline_print(algorithm, time_finish - time_start, 1);
+  return failed ? EXIT_FAILURE : 0;
 }
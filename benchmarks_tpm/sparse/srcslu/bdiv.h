@@ -22,10 +22,12 @@ void bdiv(double *diagonal, double *row, int tile_size)
   int i, j, k;
   for (i = 0; i < tile_size; i++)
     for (k = 0; k < tile_size; k++)
+    {
       row[i * tile_size + k] =
           row[i * tile_size + k] / diagonal[k * tile_size + k];
-  for (j = k + 1; j < tile_size; j++)
-    row[i * tile_size + j] =
-        row[i * tile_size + j] -
-        row[i * tile_size + k] * diagonal[k * tile_size + j];
+      for (j = k + 1; j < tile_size; j++)
+        row[i * tile_size + j] =
+            row[i * tile_size + j] -
+            row[i * tile_size + k] * diagonal[k * tile_size + j];
+    }
 }
@@ -21,10 +21,12 @@ void lu0(double *diagonal, int tile_size)
   int i, j, k;
   for (k = 0; k < tile_size; k++)
     for (i = k + 1; i < tile_size; i++)
+    {
       diagonal[i * tile_size + k] =
           diagonal[i * tile_size + k] / diagonal[k * tile_size + k];
-  for (j = k + 1; j < tile_size; j++)
-    diagonal[i * tile_size + j] =
-        diagonal[i * tile_size + j] -
-        diagonal[i * tile_size + k] * diagonal[k * tile_size + j];
+      for (j = k + 1; j < tile_size; j++)
+        diagonal[i * tile_size + j] =
+            diagonal[i * tile_size + j] -
+            diagonal[i * tile_size + k] * diagonal[k * tile_size + j];
+    }
 }
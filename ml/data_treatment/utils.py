@@ -14,7 +14,27 @@ def calculate_task_ratio(df_counters):
     return df_counters
 
 
+# Divisors applied to the raw columns, per algorithm, as each folder is
+# treated on its own: the largest instruction count, dividing PAPI_L2_TCW and
+# PAPI_L3_TCW, and the largest value of each normalized column. A divisor
+# differing between two folders of the same algorithm is recorded as None
+divisors = {}
+
+
+def record_divisors(algorithms, values):
+    for algorithm in algorithms:
+        recorded = divisors.setdefault(algorithm, {})
+        for column, value in values.items():
+            if column in recorded and recorded[column] != value:
+                recorded[column] = None
+            else:
+                recorded[column] = value
+
+
 def calculate_new_columns(df_counters):
+    tot_ins_max = df_counters["PAPI_TOT_INS"].max()
+    record_divisors(df_counters["algorithm"].unique(), {"PAPI_TOT_INS": tot_ins_max})
+
     df_counters["ilp"] = df_counters["PAPI_TOT_INS"] / df_counters["PAPI_TOT_CYC"]
     df_counters["cpi"] = df_counters["PAPI_TOT_CYC"] / df_counters["PAPI_TOT_INS"]
     df_counters["cmr"] = df_counters["PAPI_L3_TCM"] / df_counters["PAPI_L3_TCR"]
@@ -33,12 +53,8 @@ def calculate_new_columns(df_counters):
     df_counters["PAPI_RES_STL"] = (
         df_counters["PAPI_RES_STL"] / df_counters["PAPI_TOT_INS"]
     )
-    df_counters["PAPI_L2_TCW"] = (
-        df_counters["PAPI_L2_TCW"] / df_counters["PAPI_TOT_INS"].max()
-    )
-    df_counters["PAPI_L3_TCW"] = (
-        df_counters["PAPI_L3_TCW"] / df_counters["PAPI_TOT_INS"].max()
-    )
+    df_counters["PAPI_L2_TCW"] = df_counters["PAPI_L2_TCW"] / tot_ins_max
+    df_counters["PAPI_L3_TCW"] = df_counters["PAPI_L3_TCW"] / tot_ins_max
     df_counters["PAPI_L3_TCM"] = (
         df_counters["PAPI_L3_TCM"] / df_counters["PAPI_TOT_INS"]
     )
@@ -89,14 +105,17 @@ def normalize(df):
                         "normalized_time",
                     ] /= default_time
 
-
-    df["matrix_size_normalized"] = df["matrix_size"] / df["matrix_size"].max()
-    df["tile_size_normalized"] = df["tile_size"] / df["tile_size"].max()
-    df["number_of_tasks_normalized"] = (
-        df["number_of_tasks"] / df["number_of_tasks"].max()
-    )
-    df["case_normalized"] = df["case"] / df["case"].max()
-    df["frequency_normalized"] = df["frequency"] / df["frequency"].max()
+    maxima = {}
+    for column in [
+        "matrix_size",
+        "tile_size",
+        "number_of_tasks",
+        "case",
+        "frequency",
+    ]:
+        maxima[column] = df[column].max()
+        df[column + "_normalized"] = df[column] / maxima[column]
+    record_divisors(df["algorithm"].unique(), maxima)
 
     return df
 
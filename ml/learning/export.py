@@ -0,0 +1,116 @@
+import os
+import numpy as np
+from sklearn.ensemble import (
+    GradientBoostingRegressor,
+    RandomForestRegressor,
+    ExtraTreesRegressor,
+)
+from sklearn.tree import DecisionTreeRegressor
+
+
+def feature_divisors(feature_cols, algorithm_divisors, algorithm):
+    # Raw feature names as computed by TPMpower, and the divisor that turns
+    # them into the training features, as recorded by data_treatment/utils
+    # for the algorithm of the model
+    if algorithm_divisors is None:
+        raise ValueError(f"No divisors recorded for {algorithm}")
+    names = []
+    divisors = []
+    for col in feature_cols:
+        raw = col.replace("_normalized", "")
+        names.append(raw)
+        if raw in ["PAPI_L2_TCW", "PAPI_L3_TCW"]:
+            divisor = algorithm_divisors.get("PAPI_TOT_INS")
+        elif col.endswith("_normalized"):
+            divisor = algorithm_divisors.get(raw)
+        else:
+            divisor = 1.0
+        if divisor is None:
+            raise ValueError(
+                f"Cannot export {algorithm}: the divisor of {raw} is unknown "
+                "or differs between the merged folders"
+            )
+        divisors.append(divisor)
+    return names, np.array(divisors, dtype=float)
+
+
+def scaler_parameters(scaler, n):
+    center = getattr(scaler, "center_", None)
+    if center is None:
+        center = getattr(scaler, "mean_", None)
+    if center is None:
+        center = getattr(scaler, "min_", None)
+        if center is not None:
+            # MinMaxScaler: x * scale_ + min_
+            return -scaler.min_ / scaler.scale_, 1.0 / scaler.scale_
+    scale = getattr(scaler, "scale_", None)
+    center = np.zeros(n) if center is None else np.asarray(center)
+    scale = np.ones(n) if scale is None else np.asarray(scale)
+    return center, scale
+
+
+def ensemble(estimator, x_sample):
+    # Trees, base and scale such that prediction = base + scale * sum(trees)
+    if isinstance(estimator, GradientBoostingRegressor):
+        trees = [t[0] for t in estimator.estimators_]
+        if estimator.init_ == "zero":
+            base = 0.0
+        else:
+            base = float(estimator.init_.predict(x_sample[:1])[0])
+        return trees, base, estimator.learning_rate
+    if isinstance(estimator, (RandomForestRegressor, ExtraTreesRegressor)):
+        return estimator.estimators_, 0.0, 1.0 / len(estimator.estimators_)
+    if isinstance(estimator, DecisionTreeRegressor):
+        return [estimator], 0.0, 1.0
+    raise ValueError(f"Cannot export {type(estimator).__name__}, only sklearn trees")
+
+
+def export_model(pipeline, df, feature_cols, algorithm_divisors, algorithm, filename):
+    # Write a fitted scaler + tree ensemble pipeline in the text format read by
+    # power/include/monitor/model.h. The scaling and the normalization of the
+    # algorithm the model is exported for are folded into the split
+    # thresholds, so TPMpower evaluates raw features
+    scaler = pipeline.named_steps["scaler"]
+    estimator = pipeline.named_steps["estimator"]
+
+    names, divisors = feature_divisors(feature_cols, algorithm_divisors, algorithm)
+    center, scale = scaler_parameters(scaler, len(feature_cols))
+    trees, base, factor = ensemble(
+        estimator, scaler.transform(df[feature_cols].iloc[:1])
+    )
+
+    roots = []
+    nodes = []
+    for tree in trees:
+        t = tree.tree_
+        offset = len(nodes)
+        roots.append(offset)
+        for i in range(t.node_count):
+            if t.children_left[i] == -1:
+                nodes.append((-1, 0.0, -1, -1, float(t.value[i].ravel()[0])))
+            else:
+                f = t.feature[i]
+                threshold = (t.threshold[i] * scale[f] + center[f]) * divisors[f]
+                nodes.append(
+                    (
+                        int(f),
+                        float(threshold),
+                        offset + int(t.children_left[i]),
+                        offset + int(t.children_right[i]),
+                        0.0,
+                    )
+                )
+
+    os.makedirs(os.path.dirname(filename), exist_ok=True)
+    with open(filename, "w") as file:
+        file.write("tpm_model 1\n")
+        file.write(f"features {len(names)}\n")
+        file.write(" ".join(names) + "\n")
+        file.write(f"trees {len(trees)} {base!r} {factor!r}\n")
+        file.write(f"nodes {len(nodes)}\n")
+        for root in roots:
+            file.write(f"tree {root}\n")
+        for node in nodes:
+            file.write(f"{node[0]} {node[1]!r} {node[2]} {node[3]} {node[4]!r}\n")
+
+    print(f"Model exported to {filename}")
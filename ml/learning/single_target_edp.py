@@ -16,6 +16,8 @@ import os
 import sys
 
 import data_treatment.dictionaries as dict
+import data_treatment.utils as utils
+import learning.export as export
 import plot.plot as plot
 
 
@@ -161,6 +163,17 @@ def single_target_model_regression(
 
         print(f"Best parameters for {name}: ", grid_search.best_params_)
 
+        # Export the model for TPMpower (case 0) when asked, e.g. EXPORT_MODEL=GB
+        if os.getenv("EXPORT_MODEL") == name:
+            export.export_model(
+                grid_search.best_estimator_,
+                df,
+                feature_cols,
+                utils.divisors.get(train_algorithms[0]),
+                train_algorithms[0],
+                f"misc/results/models/model_{architecture}_{train_algorithms[0]}_{TARGET}.txt",
+            )
+
         test_pred = grid_search.predict(test[feature_cols])
 
         test["predicted_value"] = test_pred
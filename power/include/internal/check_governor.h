@@ -2,6 +2,16 @@ struct cpufreq_policy *current_governor;
 
 void TPM_power_check_current_governor()
 {
+    if (TPM_SIMULATED)
+    {
+        if (!TPM_power_sim_governor_is("ondemand"))
+        {
+            fprintf(stderr, "Current governor is not ondemand\n");
+            exit(EXIT_FAILURE);
+        }
+        return;
+    }
+
     /* Checking for CPU 0 */
     current_governor = cpufreq_get_policy(0);
     int ret = strcmp(current_governor->governor, "ondemand");
@@ -7,11 +7,24 @@ int frequency_to_set;
 int default_frequency;
 int combination_of_tasks;
 
+/* Frequency transitions are skipped for tasks expected to last less than
+ * TPM_HYSTERESIS times the measured transition latency (0 disables it) */
+double TPM_HYSTERESIS;
+char *TPM_LATENCY_FILE;
+
+/* Endpoint answering task duration/energy queries, and optional estimates
+ * from a previous run used as a warm start */
+char *TPM_QUERY_ENDPOINT;
+char *TPM_ESTIMATES_FILE;
+
+/* Optional per task instance log of the delivered frequency and energy */
+char *TPM_INSTANCES_FILE;
+
 static const char *cholesky_tasks[] = {"potrf", "gemm", "trsm", "syrk"};
-static const char *qr_tasks[] = {"geqrt", "ormqr", "tsmqr", "tsqrt"};
+static const char *qr_tasks[] = {"geqrt", "ormqr", "tsmqr", "tsqrt", "ttqrt", "ttmqr"};
 static const char *lu_tasks[] = {"getrfpiv", "gemm", "trsmswp", "geswp"};
 static const char *sylsvd_tasks[] = {"trsyl", "gesvd", "geev", "gemm"};
-static const char *invert_tasks[] = {"getrf", "gemm", "trsm", "getri"};
+static const char *invert_tasks[] = {"getrfpiv", "gemm", "trsmswp", "geswp", "lacpy", "trsm", "trtri", "colswp"};
 static const char *sparselu_tasks[] = {"lu0", "fwd", "bdiv", "bmod"};
 static const char *dgram_tasks[] = {"laset", "syssq", "gessq", "gram", "plssq", "plssq2"};
 static const char *dcesca_tasks[] = {"laset", "gesum", "gessq", "geadd", "cesca", "plssq", "plssq2"};
@@ -35,3 +48,29 @@ static const char *dsymm_tasks[] = {"symm", "gemm"};
 static const char *dlantr_tasks[] = {"laset", "lantr", "lange", "langemax"};
 static const char *dlansy_tasks[] = {"laset", "lansy", "lange", "langemax"};
 static const char *dlange_tasks[] = {"laset", "lange", "langemax"};
+
+int TPM_power_getenv_int(const char *name, int default_value)
+{
+    char *value = getenv(name);
+    return value ? atoi(value) : default_value;
+}
+
+double TPM_power_getenv_double(const char *name, double default_value)
+{
+    char *value = getenv(name);
+    return value ? atof(value) : default_value;
+}
+
+char *TPM_power_getenv_string(const char *name, char *default_value)
+{
+    char *value = getenv(name);
+    return value ? value : default_value;
+}
+
+/* Monotonic time in seconds */
+double TPM_power_now()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1000000000.0;
+}
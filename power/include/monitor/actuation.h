@@ -0,0 +1,121 @@
+/* Frequency writes are slow sysfs accesses, they are done by one worker per
+ * package so that they neither delay the decisions nor each other */
+#define TPM_ACTUATION_QUEUE_SIZE (1 << 12)
+
+typedef struct
+{
+    unsigned int cpu;
+    unsigned long frequency;
+} Actuation;
+
+typedef struct
+{
+    SPSCQueue queue;
+    pthread_t thread;
+    int stop;
+} ActuationWorker;
+
+ActuationWorker *actuation_workers = NULL;
+int num_actuation_workers = 0;
+
+static void TPM_power_actuation_drain(ActuationWorker *worker)
+{
+    Actuation *actuation;
+    while ((actuation = (Actuation *)TPM_power_queue_front(&worker->queue)) != NULL)
+    {
+        TPM_power_set_frequency(actuation->cpu, actuation->frequency);
+        TPM_power_queue_release(&worker->queue);
+    }
+}
+
+static void *TPM_power_actuation_run(void *arg)
+{
+    ActuationWorker *worker = (ActuationWorker *)arg;
+    while (1)
+    {
+        TPM_power_actuation_drain(worker);
+        if (__atomic_load_n(&worker->stop, __ATOMIC_ACQUIRE))
+        {
+            /* Requests made before the stop are visible now */
+            TPM_power_actuation_drain(worker);
+            break;
+        }
+        if (TPM_power_queue_prepare_wait(&worker->queue))
+        {
+            struct pollfd fd = {worker->queue.eventfd, POLLIN, 0};
+            poll(&fd, 1, -1);
+            TPM_power_queue_woken(&worker->queue);
+        }
+    }
+    return NULL;
+}
+
+/* One worker per package of the online CPUs */
+void TPM_power_actuation_start()
+{
+    int ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+    for (int cpu = 0; cpu < ncpus && cpu < MAX_CPUS; cpu++)
+    {
+        if (cpu_package[cpu] + 1 > num_actuation_workers)
+            num_actuation_workers = cpu_package[cpu] + 1;
+    }
+    if (num_actuation_workers == 0)
+        num_actuation_workers = 1;
+
+    actuation_workers = (ActuationWorker *)aligned_alloc(TPM_CACHE_LINE,
+                                                         num_actuation_workers * sizeof(ActuationWorker));
+    if (!actuation_workers)
+    {
+        fprintf(stderr, "Failed to allocate memory for actuation_workers\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(actuation_workers, 0, num_actuation_workers * sizeof(ActuationWorker));
+    for (int i = 0; i < num_actuation_workers; i++)
+    {
+        TPM_power_queue_init(&actuation_workers[i].queue, TPM_ACTUATION_QUEUE_SIZE, sizeof(Actuation));
+        if (pthread_create(&actuation_workers[i].thread, NULL, TPM_power_actuation_run,
+                           &actuation_workers[i]) != 0)
+        {
+            fprintf(stderr, "Couldn't start actuation worker %d\n", i);
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+/* Called by the decision stage only, it is the single producer of every
+ * worker queue. Without workers the frequency is set right away */
+void TPM_power_actuate(unsigned int cpu, unsigned long frequency)
+{
+    if (actuation_workers == NULL)
+    {
+        TPM_power_set_frequency(cpu, frequency);
+        return;
+    }
+    int package = cpu < MAX_CPUS ? cpu_package[cpu] : 0;
+    ActuationWorker *worker = &actuation_workers[package < num_actuation_workers ? package : 0];
+    Actuation actuation = {cpu, frequency};
+    TPM_power_queue_push(&worker->queue, &actuation);
+    TPM_power_queue_notify(&worker->queue);
+}
+
+void TPM_power_actuation_stop()
+{
+    for (int i = 0; i < num_actuation_workers; i++)
+    {
+        uint64_t one = 1;
+        __atomic_store_n(&actuation_workers[i].stop, 1, __ATOMIC_RELEASE);
+        if (write(actuation_workers[i].queue.eventfd, &one, sizeof(one)) != sizeof(one))
+        {
+            fprintf(stderr, "Failed to stop actuation worker %d\n", i);
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (int i = 0; i < num_actuation_workers; i++)
+    {
+        pthread_join(actuation_workers[i].thread, NULL);
+        TPM_power_queue_finalize(&actuation_workers[i].queue);
+    }
+    free(actuation_workers);
+    actuation_workers = NULL;
+    num_actuation_workers = 0;
+}
@@ -8,9 +8,16 @@
 #include <sys/time.h>
 #include <unistd.h>
 #include <inttypes.h>
+#include <math.h>
+#include <sched.h>
+#include <time.h>
 
 #define SYSFS_RAPL_DIR "/sys/devices/virtual/powercap/intel-rapl"
 #define MAX_PKGS 4 // FIXME considering a maximum of 4 packages
+#define MAX_CPUS 512
+
+#define MSR_IA32_MPERF 0xE7
+#define MSR_IA32_APERF 0xE8
 
 #define TPM_MESSAGE_SIZE 26
 #define TPM_STRING_SIZE 10
@@ -21,4 +28,5 @@ static char *pkg_energy_maxuj[MAX_PKGS];
 static char *dram_energy_uj[MAX_PKGS];
 static char *dram_energy_maxuj[MAX_PKGS];
 void *zmq_server;
+void *zmq_query;
 void *zmq_context;
\ No newline at end of file
@@ -5,10 +5,20 @@ typedef struct
     int num_tasks;
 } AlgorithmTasks;
 
-const char **TPM_power_control(int selected_case, const char *task, unsigned int cpu,
-                               unsigned long frequency_to_set,
-                               unsigned long original_frequency)
+const char **task_names = NULL;
+int num_tasks = 0;
+
+/* Last frequency requested on each CPU, 0 when unknown */
+unsigned long current_frequency[MAX_CPUS];
+
+/* Resolve the tasks of the current algorithm once, the returned list is NULL
+ * terminated */
+const char **TPM_power_control_init()
 {
+    if (task_names != NULL)
+        return task_names;
+    TPM_power_domains_init();
+
     static AlgorithmTasks algorithms[] = {
         {"cholesky", cholesky_tasks, sizeof(cholesky_tasks) / sizeof(cholesky_tasks[0])},
         {"qr", qr_tasks, sizeof(qr_tasks) / sizeof(qr_tasks[0])},
@@ -40,14 +50,12 @@ const char **TPM_power_control(int selected_case, const char *task, unsigned int
         {"dlange", dlange_tasks, sizeof(dlange_tasks) / sizeof(dlange_tasks[0])},
     };
 
-    const char **task_names = NULL;
-    int num_tasks = 0;
     for (int i = 0; i < sizeof(algorithms) / sizeof(algorithms[0]); ++i)
     {
         if (!strcmp(ALGORITHM, algorithms[i].algorithm))
         {
             num_tasks = algorithms[i].num_tasks;
-            task_names = malloc(sizeof(char *) * num_tasks);
+            task_names = malloc(sizeof(char *) * (num_tasks + 1));
             if (!task_names)
             {
                 fprintf(stderr, "Failed to allocate memory for task_names\n");
@@ -57,6 +65,7 @@ const char **TPM_power_control(int selected_case, const char *task, unsigned int
             {
                 task_names[j] = algorithms[i].task_names[j];
             }
+            task_names[num_tasks] = NULL;
             break;
         }
     }
@@ -67,29 +76,95 @@ const char **TPM_power_control(int selected_case, const char *task, unsigned int
         exit(EXIT_FAILURE);
     }
 
+    return task_names;
+}
+
+/* Index of the task in the algorithm task list, -1 if unknown */
+int TPM_power_task_index(const char *task)
+{
+    for (int i = 0; i < num_tasks; ++i)
+    {
+        if (!strcmp(task, task_names[i]))
+            return i;
+    }
+    return -1;
+}
+
+/* Move the domain of cpu to the highest request of its members. Skip
+ * redundant writes, and transitions that would not settle before the task is
+ * expected to finish */
+static void TPM_power_apply_domain(int task, unsigned int cpu)
+{
+    unsigned long frequency = TPM_power_domain_target(cpu);
+    if (frequency == 0 || current_frequency[cpu] == frequency)
+        return;
+
+    if (TPM_HYSTERESIS > 0 && current_frequency[cpu] != 0)
+    {
+        double latency = frequency > current_frequency[cpu] ? latency_up[cpu] : latency_down[cpu];
+        double expected = TPM_power_expected_duration(task, frequency);
+        if (expected >= 0 && expected < TPM_HYSTERESIS * latency)
+        {
+            TPM_power_stats_add(&stats->transitions_skipped, 1);
+            return;
+        }
+    }
+
+    int domain = domain_of[cpu];
+    for (int member = domain; member < domains_count; member++)
+    {
+        if (domain_of[member] == domain)
+        {
+            current_frequency[member] = frequency;
+            TPM_power_stats_set(&stats->cpu_frequency[member], frequency);
+        }
+    }
+    TPM_power_actuate(cpu, frequency);
+    TPM_power_stats_add(&stats->transitions_issued, 1);
+}
+
+static void TPM_power_request_frequency(int task, unsigned int cpu,
+                                        unsigned long frequency)
+{
+    if (cpu >= (unsigned int)domains_count)
+    {
+        TPM_power_actuate(cpu, frequency);
+        TPM_power_stats_add(&stats->transitions_issued, 1);
+        return;
+    }
+    member_request[cpu] = frequency;
+    TPM_power_apply_domain(task, cpu);
+}
+
+/* The last task running on cpu is over: its request no longer holds the
+ * domain up. An idle domain stays at its last frequency */
+void TPM_power_control_release(int task, unsigned int cpu)
+{
+    if (cpu >= (unsigned int)domains_count || member_request[cpu] == 0 || running_depth[cpu] > 0)
+        return;
+    member_request[cpu] = 0;
+    if (domain_size[domain_of[cpu]] > 1)
+        TPM_power_apply_domain(task, cpu);
+}
+
+void TPM_power_control(int selected_case, int task, unsigned int cpu,
+                       unsigned long frequency_to_set,
+                       unsigned long original_frequency)
+{
     if (selected_case >= 1 && selected_case <= ((1 << num_tasks) - 1))
     {
         int task_mask = selected_case - 1;
-        int task_found = 0;
-        for (int i = 0; i < num_tasks; ++i)
+        if (task >= 0 && (task_mask & (1 << task)))
         {
-
-            if (!strcmp(task, task_names[i]) && (task_mask & (1 << i)))
-            {
-                TPM_power_set_frequency(cpu, frequency_to_set);
-                task_found = 1;
-                break;
-            }
+            TPM_power_request_frequency(task, cpu, frequency_to_set);
         }
-        if (!task_found)
+        else
         {
-            TPM_power_set_frequency(cpu, original_frequency);
+            TPM_power_request_frequency(task, cpu, original_frequency);
         }
     }
     else if (selected_case == (1 << num_tasks))
     {
-        TPM_power_set_frequency(cpu, frequency_to_set);
+        TPM_power_request_frequency(task, cpu, frequency_to_set);
     }
-
-    return task_names;
 }
@@ -0,0 +1,210 @@
+/* Per-core activity from the APERF, MPERF and TSC counters, and a per-core
+ * power model splitting the package RAPL power between the cores. Over each
+ * package sampling period, the power is fitted online as
+ *   package = static + k * sum over its cores of APERF * (f_eff / f_tsc)^2 / dt
+ * i.e. dynamic energy per cycle growing with the square of the voltage,
+ * which follows the frequency. A task then costs k times its own weighted
+ * cycles, plus its core share of the static power */
+#define MSR_IA32_TSC 0x10
+#define TPM_CORES_DECAY 0.99       // Forgetting factor of the fit, per sample
+#define TPM_CORES_MIN_SAMPLES 8    // Samples before trusting the fit
+#define TPM_CORES_TOLERANCE 0.1    // Delivered frequency within 10% of the request
+
+typedef struct
+{
+    uint64_t aperf;
+    uint64_t mperf;
+    uint64_t tsc;
+} CoreCounters;
+
+/* Exponentially weighted sums of the (weighted cycles rate, power) samples */
+typedef struct
+{
+    double weight;
+    double x;
+    double y;
+    double xx;
+    double xy;
+    unsigned long samples;
+    double static_power;  // Watts
+    double cycle_energy;  // Joules per weighted cycle
+} PackageModel;
+
+int cpu_package[MAX_CPUS];
+int cores_per_package[MAX_PKGS];
+int cores_fd[MAX_CPUS];
+int cores_available = 0;
+int cores_count = 0;
+double cores_tsc_hz = 0.0;
+CoreCounters cores_last[MAX_CPUS];
+PackageModel package_models[MAX_PKGS];
+
+int TPM_power_cores_read(unsigned int cpu, CoreCounters *counters)
+{
+    if (!cores_available || cpu >= (unsigned int)cores_count)
+        return -1;
+    if (TPM_SIMULATED)
+        return TPM_power_sim_read_counters(cpu, &counters->aperf, &counters->mperf, &counters->tsc);
+    if (TPM_power_read_msr(cores_fd[cpu], MSR_IA32_APERF, &counters->aperf) != 0 ||
+        TPM_power_read_msr(cores_fd[cpu], MSR_IA32_MPERF, &counters->mperf) != 0 ||
+        TPM_power_read_msr(cores_fd[cpu], MSR_IA32_TSC, &counters->tsc) != 0)
+        return -1;
+    return 0;
+}
+
+/* Delivered frequency (kHz) while busy, fraction of the time busy, and
+ * cycles weighted by the square of the frequency ratio, between two reads */
+void TPM_power_core_activity(const CoreCounters *start, const CoreCounters *end,
+                             double *frequency, double *busy, double *weighted)
+{
+    double aperf = (double)(end->aperf - start->aperf);
+    double mperf = (double)(end->mperf - start->mperf);
+    double tsc = (double)(end->tsc - start->tsc);
+    double ratio = mperf > 0 ? aperf / mperf : 0.0;
+    *frequency = ratio * cores_tsc_hz / 1e3;
+    *busy = tsc > 0 ? mperf / tsc : 0.0;
+    *weighted = aperf * ratio * ratio;
+}
+
+/* Topology of the CPUs, and access to their counters through the msr driver
+ * (or the simulated machine). Without them, only the package share of the
+ * energy is estimated */
+void TPM_power_cores_init()
+{
+    char fn[TPM_FILENAME_SIZE * 2];
+    cores_count = TPM_SIMULATED ? sim.cpus : sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores_count > MAX_CPUS)
+        cores_count = MAX_CPUS;
+
+    memset(cores_per_package, 0, sizeof(cores_per_package));
+    memset(package_models, 0, sizeof(package_models));
+    for (int cpu = 0; cpu < MAX_CPUS; cpu++)
+    {
+        cpu_package[cpu] = 0;
+        cores_fd[cpu] = -1;
+        snprintf(fn, sizeof(fn), "%s/sys/devices/system/cpu/cpu%d/topology/physical_package_id",
+                 TPM_SYSFS_ROOT, cpu);
+        const char *s = read_string(fn);
+        if (s)
+        {
+            int package = atoi(s);
+            cpu_package[cpu] = (package >= 0 && package < MAX_PKGS) ? package : 0;
+            free((void *)s);
+        }
+        if (cpu < cores_count)
+            cores_per_package[cpu_package[cpu]]++;
+    }
+
+    cores_available = 1;
+    for (int cpu = 0; cpu < cores_count && !TPM_SIMULATED; cpu++)
+    {
+        snprintf(fn, sizeof(fn), "/dev/cpu/%d/msr", cpu);
+        cores_fd[cpu] = open(fn, O_RDONLY);
+        if (cores_fd[cpu] < 0)
+        {
+            fprintf(stderr, "msr driver unavailable, per-core energy disabled\n");
+            cores_available = 0;
+            break;
+        }
+    }
+
+    /* TSC rate, against the monotonic clock over 20 ms */
+    CoreCounters start, end;
+    if (cores_available && TPM_power_cores_read(0, &start) == 0)
+    {
+        double since = TPM_power_now();
+        struct timespec wait = {0, 20000000};
+        nanosleep(&wait, NULL);
+        if (TPM_power_cores_read(0, &end) == 0)
+            cores_tsc_hz = (end.tsc - start.tsc) / (TPM_power_now() - since);
+    }
+    if (cores_tsc_hz <= 0)
+        cores_available = 0;
+
+    for (int cpu = 0; cpu < cores_count && cores_available; cpu++)
+        TPM_power_cores_read(cpu, &cores_last[cpu]);
+}
+
+/* One sampling period of the packages: add the (weighted cycles rate, power)
+ * samples to the fit of each package. With no variation of the activity yet,
+ * the power is taken as dynamic only */
+void TPM_power_cores_sample(const double *power, int packages, double elapsed)
+{
+    if (!cores_available || elapsed <= 0)
+        return;
+
+    double rate[MAX_PKGS] = {0};
+    for (int cpu = 0; cpu < cores_count; cpu++)
+    {
+        CoreCounters counters;
+        if (TPM_power_cores_read(cpu, &counters) != 0)
+            continue;
+        double frequency, busy, weighted;
+        TPM_power_core_activity(&cores_last[cpu], &counters, &frequency, &busy, &weighted);
+        rate[cpu_package[cpu]] += weighted / elapsed;
+        cores_last[cpu] = counters;
+    }
+
+    for (int i = 0; i < packages && i < MAX_PKGS; i++)
+    {
+        PackageModel *model = &package_models[i];
+        double x = rate[i], y = power[i];
+        model->weight = TPM_CORES_DECAY * model->weight + 1.0;
+        model->x = TPM_CORES_DECAY * model->x + x;
+        model->y = TPM_CORES_DECAY * model->y + y;
+        model->xx = TPM_CORES_DECAY * model->xx + x * x;
+        model->xy = TPM_CORES_DECAY * model->xy + x * y;
+        model->samples++;
+
+        double mean_x = model->x / model->weight, mean_y = model->y / model->weight;
+        double variance = model->xx / model->weight - mean_x * mean_x;
+        double covariance = model->xy / model->weight - mean_x * mean_y;
+        if (model->samples >= TPM_CORES_MIN_SAMPLES && variance > 1e-6 * mean_x * mean_x &&
+            covariance > 0)
+        {
+            model->cycle_energy = covariance / variance;
+            model->static_power = mean_y - model->cycle_energy * mean_x;
+            if (model->static_power < 0)
+            {
+                model->static_power = 0;
+                model->cycle_energy = mean_y / mean_x;
+            }
+            else if (model->static_power > mean_y)
+            {
+                model->static_power = mean_y;
+                model->cycle_energy = 0;
+            }
+        }
+        else if (mean_x > 0)
+        {
+            model->static_power = 0;
+            model->cycle_energy = mean_y / mean_x;
+        }
+    }
+}
+
+/* Energy (Joules) of a task run on a CPU between two reads, and the
+ * frequency it was actually delivered. Negative when unknown */
+double TPM_power_core_energy(unsigned int cpu, const CoreCounters *start,
+                             const CoreCounters *end, double duration,
+                             double *frequency, double *busy)
+{
+    double weighted;
+    TPM_power_core_activity(start, end, frequency, busy, &weighted);
+    const PackageModel *model = &package_models[cpu_package[cpu]];
+    if (model->samples == 0)
+        return -1.0;
+    return model->cycle_energy * weighted +
+           model->static_power * duration / cores_per_package[cpu_package[cpu]];
+}
+
+void TPM_power_cores_finalize()
+{
+    for (int cpu = 0; cpu < MAX_CPUS; cpu++)
+    {
+        if (cores_fd[cpu] >= 0)
+            close(cores_fd[cpu]);
+        cores_fd[cpu] = -1;
+    }
+    cores_available = 0;
+}
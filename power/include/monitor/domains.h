@@ -0,0 +1,92 @@
+/* Frequency domains: CPUs sharing a cpufreq policy (a module, or a whole
+ * package on many parts) run at one frequency, whichever member the write
+ * went through. Each CPU keeps its own request and the domain runs at the
+ * highest request of its members, so that a task asking for a low frequency
+ * does not slow down its neighbours */
+int domain_of[MAX_CPUS];   // Lowest CPU of the domain
+int domain_size[MAX_CPUS]; // Indexed by the lowest CPU
+int num_domains = 0;
+int domains_count = 0; // CPUs covered
+
+/* Frequency requested by the task running on each CPU, 0 when idle */
+unsigned long member_request[MAX_CPUS];
+
+/* CPUs listed in a cpufreq file ("0 1 2 3"), -1 if it is missing */
+static int TPM_power_read_cpu_list(int cpu, const char *file, int *cpus, int max)
+{
+    char fn[TPM_FILENAME_SIZE * 2];
+    snprintf(fn, sizeof(fn), "%s/sys/devices/system/cpu/cpu%d/cpufreq/%s",
+             TPM_SYSFS_ROOT, cpu, file);
+    const char *s = read_string(fn);
+    if (!s)
+        return -1;
+
+    int count = 0;
+    const char *cursor = s;
+    char *end;
+    while (count < max)
+    {
+        long member = strtol(cursor, &end, 10);
+        if (end == cursor)
+            break;
+        if (member >= 0 && member < MAX_CPUS)
+            cpus[count++] = (int)member;
+        cursor = end;
+    }
+    free((void *)s);
+    return count;
+}
+
+/* Domains from related_cpus (all the CPUs of the policy, online or not), or
+ * affected_cpus on older kernels. A CPU without either is its own domain */
+void TPM_power_domains_init()
+{
+    domains_count = TPM_SIMULATED ? sim.cpus : sysconf(_SC_NPROCESSORS_ONLN);
+    if (domains_count > MAX_CPUS)
+        domains_count = MAX_CPUS;
+
+    for (int cpu = 0; cpu < MAX_CPUS; cpu++)
+    {
+        domain_of[cpu] = cpu;
+        domain_size[cpu] = 0;
+        member_request[cpu] = 0;
+    }
+
+    int cpus[MAX_CPUS];
+    for (int cpu = 0; cpu < domains_count; cpu++)
+    {
+        int count = TPM_power_read_cpu_list(cpu, "related_cpus", cpus, MAX_CPUS);
+        if (count <= 0)
+            count = TPM_power_read_cpu_list(cpu, "affected_cpus", cpus, MAX_CPUS);
+        int lowest = cpu;
+        for (int i = 0; i < count; i++)
+        {
+            if (cpus[i] < lowest)
+                lowest = cpus[i];
+        }
+        domain_of[cpu] = lowest;
+    }
+
+    num_domains = 0;
+    for (int cpu = 0; cpu < domains_count; cpu++)
+    {
+        if (domain_size[domain_of[cpu]]++ == 0)
+            num_domains++;
+    }
+}
+
+/* Highest request among the CPUs sharing the domain of cpu, 0 if none */
+unsigned long TPM_power_domain_target(unsigned int cpu)
+{
+    int domain = domain_of[cpu];
+    unsigned long target = 0;
+    for (int member = domain, seen = 0; member < domains_count && seen < domain_size[domain]; member++)
+    {
+        if (domain_of[member] != domain)
+            continue;
+        seen++;
+        if (member_request[member] > target)
+            target = member_request[member];
+    }
+    return target;
+}
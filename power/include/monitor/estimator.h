@@ -0,0 +1,424 @@
+/* Online estimation of task durations and energy, fed by the task
+ * start/finish events. The daemon runs for a single tile size, so estimates
+ * are kept per task type and per requested frequency */
+#define TPM_EWMA_WEIGHT 0.125
+#define TPM_MAX_FREQUENCIES 8
+#define TPM_HISTOGRAM_BUCKETS 32 // log2 buckets of microseconds
+#define TPM_POWER_SAMPLING 0.01  // Package power is refreshed every 10 ms
+#define TPM_QUERY_REPLY_SIZE 8192
+#define TPM_MAX_NESTING 8 // Nested tasks running on the same CPU
+
+typedef struct
+{
+    unsigned long frequency;
+    unsigned long count;
+    double ewma;
+    double mean;
+    double m2; // Sum of squared differences to the mean (Welford)
+    double min;
+    double max;
+    double energy; // Joules, accumulated over all instances
+    unsigned long histogram[TPM_HISTOGRAM_BUCKETS];
+    /* From the per-core counters, over the instances where they were read */
+    unsigned long measured;
+    double core_energy;         // Joules
+    double effective_frequency; // kHz
+    double busy;                // Fraction of the time out of idle states
+    unsigned long honored;      // Delivered frequency close to the request
+} TaskEstimate;
+
+/* estimates[task * TPM_MAX_FREQUENCIES + slot] */
+TaskEstimate *task_estimates = NULL;
+int estimator_num_tasks = 0;
+const char **estimator_names = NULL;
+
+/* Tasks running on a CPU, since when and at which frequency. A task
+ * creating and waiting on nested tasks stays below them */
+typedef struct
+{
+    int task;
+    double since;
+    unsigned long frequency;
+    double energy_share;
+    int counted; // counters read at the start
+    CoreCounters counters;
+} RunningTask;
+
+RunningTask running_tasks[MAX_CPUS][TPM_MAX_NESTING];
+int running_depth[MAX_CPUS];
+
+/* Package power is shared evenly between the tasks running on the package:
+ * energy_share integrates power / running tasks over time, so that the
+ * energy of a task is the difference of the integral at finish and start */
+int package_running_tasks[MAX_PKGS];
+double package_power[MAX_PKGS];
+double package_energy_share[MAX_PKGS];
+double package_last_update[MAX_PKGS];
+uint64_t package_last_uj[MAX_PKGS];
+double package_last_sample = 0.0;
+int estimator_packages = 0;
+
+/* One line per task instance, when TPM_INSTANCES_FILE is set */
+FILE *instances_file = NULL;
+
+void TPM_power_estimator_init(const char **names, int num_tasks, int active_packages)
+{
+    estimator_names = names;
+    estimator_num_tasks = num_tasks;
+    estimator_packages = active_packages;
+    task_estimates = (TaskEstimate *)calloc(num_tasks * TPM_MAX_FREQUENCIES, sizeof(TaskEstimate));
+    if (!task_estimates)
+    {
+        fprintf(stderr, "Failed to allocate memory for task_estimates\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int cpu = 0; cpu < MAX_CPUS; cpu++)
+        running_depth[cpu] = 0;
+    TPM_power_cores_init();
+
+    if (TPM_INSTANCES_FILE)
+    {
+        instances_file = fopen(TPM_INSTANCES_FILE, "w");
+        if (instances_file == NULL)
+        {
+            fprintf(stderr, "Couldn't open %s\n", TPM_INSTANCES_FILE);
+            exit(EXIT_FAILURE);
+        }
+        fprintf(instances_file, "task,cpu,start,duration,requested_frequency,"
+                                "effective_frequency,busy,core_energy,package_energy\n");
+    }
+
+    double now = TPM_power_now();
+    package_last_sample = now;
+    for (int i = 0; i < estimator_packages; i++)
+    {
+        package_last_uj[i] = TPM_rapl_get_uj(i, "pkg");
+        package_last_update[i] = now;
+    }
+}
+
+void TPM_power_sample_packages(double now)
+{
+    if (now - package_last_sample < TPM_POWER_SAMPLING)
+        return;
+
+    for (int i = 0; i < estimator_packages; i++)
+    {
+        uint64_t uj = TPM_rapl_get_uj(i, "pkg");
+        uint64_t delta = uj >= package_last_uj[i]
+                             ? uj - package_last_uj[i]
+                             : uj + TPM_rapl_get_maxuj(i, "pkg") - package_last_uj[i];
+        package_power[i] = delta / 1e6 / (now - package_last_sample);
+        TPM_power_stats_set_double(&stats->package_power[i], package_power[i]);
+        package_last_uj[i] = uj;
+    }
+    TPM_power_cores_sample(package_power, estimator_packages, now - package_last_sample);
+    package_last_sample = now;
+}
+
+static void TPM_power_advance_package(int package, double now)
+{
+    if (package >= estimator_packages)
+        return;
+    if (package_running_tasks[package] > 0)
+    {
+        package_energy_share[package] += (now - package_last_update[package]) *
+                                         package_power[package] /
+                                         package_running_tasks[package];
+    }
+    package_last_update[package] = now;
+}
+
+static TaskEstimate *TPM_power_estimate_slot(int task, unsigned long frequency, int create)
+{
+    TaskEstimate *slots = &task_estimates[task * TPM_MAX_FREQUENCIES];
+    for (int i = 0; i < TPM_MAX_FREQUENCIES; i++)
+    {
+        if (slots[i].count > 0 && slots[i].frequency == frequency)
+            return &slots[i];
+        if (slots[i].count == 0 && create)
+        {
+            slots[i].frequency = frequency;
+            return &slots[i];
+        }
+    }
+    return NULL;
+}
+
+void TPM_power_task_started(int task, unsigned int cpu, double now,
+                            unsigned long frequency)
+{
+    if (cpu >= MAX_CPUS)
+        return;
+
+    TPM_power_sample_packages(now);
+    int package = cpu_package[cpu];
+    TPM_power_advance_package(package, now);
+    if (running_depth[cpu] == TPM_MAX_NESTING)
+    {
+        /* Tasks that never reported their end, forget the oldest one */
+        memmove(&running_tasks[cpu][0], &running_tasks[cpu][1],
+                (TPM_MAX_NESTING - 1) * sizeof(RunningTask));
+        running_depth[cpu]--;
+        package_running_tasks[package]--;
+    }
+    package_running_tasks[package]++;
+
+    RunningTask *running = &running_tasks[cpu][running_depth[cpu]++];
+    running->task = task;
+    running->since = now;
+    running->frequency = frequency;
+    running->energy_share = package_energy_share[package];
+    running->counted = TPM_power_cores_read(cpu, &running->counters) == 0;
+}
+
+static void TPM_power_estimate_update(TaskEstimate *estimate, double duration, double energy,
+                                      double core_energy, double frequency, double busy)
+{
+    estimate->count++;
+    if (estimate->count == 1)
+    {
+        estimate->ewma = duration;
+        estimate->min = duration;
+        estimate->max = duration;
+    }
+    else
+    {
+        estimate->ewma += TPM_EWMA_WEIGHT * (duration - estimate->ewma);
+        estimate->min = duration < estimate->min ? duration : estimate->min;
+        estimate->max = duration > estimate->max ? duration : estimate->max;
+    }
+    double delta = duration - estimate->mean;
+    estimate->mean += delta / estimate->count;
+    estimate->m2 += delta * (duration - estimate->mean);
+    estimate->energy += energy;
+    if (core_energy >= 0)
+    {
+        estimate->measured++;
+        estimate->core_energy += core_energy;
+        estimate->effective_frequency += frequency;
+        estimate->busy += busy;
+        if (estimate->frequency > 0 &&
+            fabs(frequency - estimate->frequency) <= TPM_CORES_TOLERANCE * estimate->frequency)
+            estimate->honored++;
+    }
+
+    uint64_t us = (uint64_t)(duration * 1e6);
+    int bucket = us == 0 ? 0 : 63 - __builtin_clzll(us);
+    estimate->histogram[bucket < TPM_HISTOGRAM_BUCKETS ? bucket : TPM_HISTOGRAM_BUCKETS - 1]++;
+}
+
+/* The duration is the one measured by the tracer, negative when it is not
+ * known and taken from the daemon clock */
+void TPM_power_task_finished(int task, unsigned int cpu, double now, double duration)
+{
+    if (cpu >= MAX_CPUS)
+        return;
+
+    int depth = running_depth[cpu] - 1;
+    while (depth >= 0 && running_tasks[cpu][depth].task != task)
+        depth--;
+    if (depth < 0)
+        return;
+    RunningTask running = running_tasks[cpu][depth];
+    memmove(&running_tasks[cpu][depth], &running_tasks[cpu][depth + 1],
+            (running_depth[cpu] - depth - 1) * sizeof(RunningTask));
+    running_depth[cpu]--;
+
+    int package = cpu_package[cpu];
+    TPM_power_sample_packages(now);
+    TPM_power_advance_package(package, now);
+    double energy = package_energy_share[package] - running.energy_share;
+    if (package_running_tasks[package] > 0)
+        package_running_tasks[package]--;
+
+    if (task < 0)
+        return;
+    if (duration < 0)
+        duration = now - running.since;
+
+    /* The counters are read when the events are handled, both ends are late
+     * by about the same queuing delay */
+    double core_energy = -1.0, frequency = 0.0, busy = 0.0;
+    CoreCounters counters;
+    if (running.counted && TPM_power_cores_read(cpu, &counters) == 0)
+        core_energy = TPM_power_core_energy(cpu, &running.counters, &counters, duration,
+                                            &frequency, &busy);
+
+    TaskEstimate *estimate = TPM_power_estimate_slot(task, running.frequency, 1);
+    if (estimate)
+        TPM_power_estimate_update(estimate, duration, energy, core_energy, frequency, busy);
+
+    if (instances_file)
+    {
+        fprintf(instances_file, "%s,%u,%f,%e,%lu,%.0f,%f,%e,%e\n", estimator_names[task], cpu,
+                running.since, duration, running.frequency, frequency, busy, core_energy, energy);
+    }
+}
+
+/* Expected duration in seconds at the given frequency, or at any frequency
+ * seen so far when there is nothing for it yet. Negative while nothing has
+ * been learned */
+double TPM_power_expected_duration(int task, unsigned long frequency)
+{
+    if (task < 0)
+        return -1.0;
+    TaskEstimate *estimate = TPM_power_estimate_slot(task, frequency, 0);
+    if (estimate)
+        return estimate->ewma;
+    TaskEstimate *slots = &task_estimates[task * TPM_MAX_FREQUENCIES];
+    for (int i = 0; i < TPM_MAX_FREQUENCIES; i++)
+    {
+        if (slots[i].count > 0)
+            return slots[i].ewma;
+    }
+    return -1.0;
+}
+
+/* Upper bound of the histogram bucket holding the given quantile */
+static double TPM_power_estimate_quantile(const TaskEstimate *estimate, double quantile)
+{
+    unsigned long target = (unsigned long)(quantile * estimate->count);
+    unsigned long cumulated = 0;
+    for (int i = 0; i < TPM_HISTOGRAM_BUCKETS; i++)
+    {
+        cumulated += estimate->histogram[i];
+        if (cumulated > target)
+            return (double)(2ULL << i) / 1e6;
+    }
+    return estimate->max;
+}
+
+static int TPM_power_estimate_format(char *buffer, size_t size, const char *task,
+                                     const TaskEstimate *estimate)
+{
+    double stddev = estimate->count > 1 ? sqrt(estimate->m2 / (estimate->count - 1)) : 0.0;
+    double measured = estimate->measured > 0 ? (double)estimate->measured : NAN;
+    return snprintf(buffer, size, "%s,%d,%lu,%lu,%e,%e,%e,%e,%e,%e,%e,%e,%e,%.0f,%f,%f\n",
+                    task, TILE, estimate->frequency, estimate->count,
+                    estimate->mean, estimate->ewma, stddev,
+                    estimate->min, estimate->max,
+                    TPM_power_estimate_quantile(estimate, 0.5),
+                    TPM_power_estimate_quantile(estimate, 0.9),
+                    estimate->energy / estimate->count,
+                    estimate->core_energy / measured,
+                    estimate->effective_frequency / measured,
+                    estimate->busy / measured,
+                    estimate->honored / measured);
+}
+
+#define TPM_ESTIMATE_HEADER "task,tile_size,frequency,count,mean,ewma,stddev,min,max,p50,p90,energy," \
+                            "core_energy,effective_frequency,busy,honored\n"
+
+/* Query format: "all", "<task>" or "<task> <frequency>". The reply holds one
+ * CSV line per matching estimate, after the header */
+int TPM_power_estimator_query(const char *request, const char **names,
+                              char *reply, size_t size)
+{
+    char task[TPM_STRING_SIZE] = {0};
+    unsigned long frequency = 0;
+    int fields = sscanf(request, "%9s %lu", task, &frequency);
+
+    int written = snprintf(reply, size, TPM_ESTIMATE_HEADER);
+    for (int i = 0; i < estimator_num_tasks && written < size; i++)
+    {
+        if (fields >= 1 && strcmp(task, "all") != 0 && strcmp(task, names[i]) != 0)
+            continue;
+        for (int j = 0; j < TPM_MAX_FREQUENCIES && written < size; j++)
+        {
+            const TaskEstimate *estimate = &task_estimates[i * TPM_MAX_FREQUENCIES + j];
+            if (estimate->count == 0 || (fields == 2 && estimate->frequency != frequency))
+                continue;
+            written += TPM_power_estimate_format(reply + written, size - written,
+                                                 names[i], estimate);
+        }
+    }
+    return written < size ? written : size - 1;
+}
+
+void TPM_power_estimator_dump(const char **names)
+{
+    char filename[TPM_FILENAME_SIZE];
+    int TPM_ITER = atoi(getenv("TPM_ITER"));
+    sprintf(filename, "task_estimates_%s_%d_%d.csv", ALGORITHM, MATRIX, TPM_ITER);
+
+    struct stat buffer;
+    int file_already_exists = (stat(filename, &buffer) == 0);
+    FILE *file = fopen(filename, "a");
+    if (file == NULL)
+    {
+        fprintf(stderr, "fopen failed\n");
+        exit(EXIT_FAILURE);
+    }
+    if (!file_already_exists)
+    {
+        fprintf(file, "algorithm,matrix_size,threads,case,%s", TPM_ESTIMATE_HEADER);
+    }
+
+    char line[512];
+    for (int i = 0; i < estimator_num_tasks; i++)
+    {
+        for (int j = 0; j < TPM_MAX_FREQUENCIES; j++)
+        {
+            const TaskEstimate *estimate = &task_estimates[i * TPM_MAX_FREQUENCIES + j];
+            if (estimate->count == 0)
+                continue;
+            TPM_power_estimate_format(line, sizeof(line), names[i], estimate);
+            fprintf(file, "%s,%d,%d,%d,%s", ALGORITHM, MATRIX, NTHREADS,
+                    combination_of_tasks, line);
+        }
+    }
+    fclose(file);
+}
+
+/* Warm start from a previous dump, so that the policy has predictions from
+ * the first task on. Only the estimates of the same algorithm and tile size
+ * are used */
+void TPM_power_estimator_load(const char *filename, const char **names)
+{
+    FILE *file = fopen(filename, "r");
+    if (file == NULL)
+        return;
+
+    char line[512];
+    char algorithm[32], task[TPM_STRING_SIZE];
+    int matrix, threads, selected_case, tile;
+    unsigned long frequency, count;
+    double mean, ewma;
+    while (fgets(line, sizeof(line), file))
+    {
+        if (sscanf(line, "%31[^,],%d,%d,%d,%9[^,],%d,%lu,%lu,%lf,%lf",
+                   algorithm, &matrix, &threads, &selected_case, task, &tile,
+                   &frequency, &count, &mean, &ewma) != 10)
+            continue;
+        if (strcmp(algorithm, ALGORITHM) != 0 || tile != TILE)
+            continue;
+        for (int i = 0; i < estimator_num_tasks; i++)
+        {
+            if (strcmp(task, names[i]) != 0)
+                continue;
+            TaskEstimate *estimate = TPM_power_estimate_slot(i, frequency, 1);
+            if (estimate && estimate->count == 0)
+            {
+                /* A single pseudo-sample, so that live data takes over quickly */
+                estimate->count = 1;
+                estimate->ewma = ewma;
+                estimate->mean = ewma;
+                estimate->min = ewma;
+                estimate->max = ewma;
+            }
+        }
+    }
+    fclose(file);
+}
+
+void TPM_power_estimator_finalize()
+{
+    free(task_estimates);
+    task_estimates = NULL;
+    if (instances_file)
+        fclose(instances_file);
+    instances_file = NULL;
+    TPM_power_cores_finalize();
+}
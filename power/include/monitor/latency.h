@@ -0,0 +1,189 @@
+/* Frequency transition latency (seconds) from a low to a high frequency and
+ * back, per CPU. Filled either by the calibration or from a previous one */
+double latency_up[MAX_CPUS];
+double latency_down[MAX_CPUS];
+
+#define TPM_LATENCY_REPETITIONS 5
+#define TPM_LATENCY_SETTLE 0.02    // 20 ms to reach a steady frequency
+#define TPM_LATENCY_WINDOW 0.00002 // 20 us sampling window
+#define TPM_LATENCY_TIMEOUT 0.1    // Give up on a transition after 100 ms
+
+typedef struct
+{
+    int msr_fd;
+    unsigned int cpu;
+} LatencyProbe;
+
+static int TPM_power_read_msr(int fd, uint32_t reg, uint64_t *value)
+{
+    return pread(fd, value, sizeof(uint64_t), reg) == sizeof(uint64_t) ? 0 : -1;
+}
+
+/* Busy spin for one window and return the effective to nominal frequency
+ * ratio seen by the core: APERF/MPERF when the msr driver is available,
+ * otherwise the kernel view of the current frequency */
+static double TPM_power_sample_ratio(LatencyProbe *probe)
+{
+    double until = TPM_power_now() + TPM_LATENCY_WINDOW;
+    if (probe->msr_fd >= 0)
+    {
+        uint64_t aperf_start, mperf_start, aperf_end, mperf_end;
+        TPM_power_read_msr(probe->msr_fd, MSR_IA32_APERF, &aperf_start);
+        TPM_power_read_msr(probe->msr_fd, MSR_IA32_MPERF, &mperf_start);
+        while (TPM_power_now() < until)
+            ;
+        TPM_power_read_msr(probe->msr_fd, MSR_IA32_APERF, &aperf_end);
+        TPM_power_read_msr(probe->msr_fd, MSR_IA32_MPERF, &mperf_end);
+        if (mperf_end == mperf_start)
+            return 0.0;
+        return (double)(aperf_end - aperf_start) / (double)(mperf_end - mperf_start);
+    }
+    while (TPM_power_now() < until)
+        ;
+    return (double)TPM_power_get_frequency(probe->cpu);
+}
+
+static double TPM_power_steady_ratio(LatencyProbe *probe, unsigned long frequency)
+{
+    TPM_power_set_frequency(probe->cpu, frequency);
+    double until = TPM_power_now() + TPM_LATENCY_SETTLE;
+    while (TPM_power_now() < until)
+        ;
+    double sum = 0.0;
+    int samples = 50;
+    for (int i = 0; i < samples; i++)
+    {
+        sum += TPM_power_sample_ratio(probe);
+    }
+    return sum / samples;
+}
+
+/* Time from the cpufreq write until the core runs at 90% of the way between
+ * the two steady states */
+static double TPM_power_transition_time(LatencyProbe *probe, unsigned long from,
+                                        unsigned long to, double from_ratio,
+                                        double to_ratio)
+{
+    TPM_power_steady_ratio(probe, from);
+
+    double threshold = from_ratio + 0.9 * (to_ratio - from_ratio);
+    double start = TPM_power_now();
+    TPM_power_set_frequency(probe->cpu, to);
+    while (TPM_power_now() - start < TPM_LATENCY_TIMEOUT)
+    {
+        double ratio = TPM_power_sample_ratio(probe);
+        if ((to_ratio > from_ratio && ratio >= threshold) ||
+            (to_ratio <= from_ratio && ratio <= threshold))
+        {
+            return TPM_power_now() - start;
+        }
+    }
+    return TPM_LATENCY_TIMEOUT;
+}
+
+static int TPM_power_compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Measure the transition latency of every online CPU, pinning the calling
+ * thread on each CPU in turn. The simulated CPUs are measured from their
+ * frequency, without pinning. Returns the number of CPUs measured */
+int TPM_power_calibrate_latency(unsigned long low_frequency,
+                                unsigned long high_frequency)
+{
+    int ncpus = TPM_SIMULATED ? sim.cpus : sysconf(_SC_NPROCESSORS_ONLN);
+    if (ncpus > MAX_CPUS)
+        ncpus = MAX_CPUS;
+
+    cpu_set_t original_mask;
+    sched_getaffinity(0, sizeof(cpu_set_t), &original_mask);
+
+    for (int cpu = 0; cpu < ncpus; cpu++)
+    {
+        LatencyProbe probe = {-1, (unsigned int)cpu};
+        if (!TPM_SIMULATED)
+        {
+            cpu_set_t mask;
+            CPU_ZERO(&mask);
+            CPU_SET(cpu, &mask);
+            if (sched_setaffinity(0, sizeof(cpu_set_t), &mask) != 0)
+            {
+                fprintf(stderr, "Couldn't pin calibration on CPU %d\n", cpu);
+                exit(EXIT_FAILURE);
+            }
+
+            char fn[TPM_FILENAME_SIZE];
+            snprintf(fn, sizeof(fn), "/dev/cpu/%d/msr", cpu);
+            probe.msr_fd = open(fn, O_RDONLY);
+            if (probe.msr_fd < 0 && cpu == 0)
+            {
+                fprintf(stderr, "msr driver unavailable, falling back to scaling_cur_freq\n");
+            }
+        }
+
+        double low_ratio = TPM_power_steady_ratio(&probe, low_frequency);
+        double high_ratio = TPM_power_steady_ratio(&probe, high_frequency);
+
+        double up[TPM_LATENCY_REPETITIONS], down[TPM_LATENCY_REPETITIONS];
+        for (int i = 0; i < TPM_LATENCY_REPETITIONS; i++)
+        {
+            up[i] = TPM_power_transition_time(&probe, low_frequency, high_frequency,
+                                              low_ratio, high_ratio);
+            down[i] = TPM_power_transition_time(&probe, high_frequency, low_frequency,
+                                                high_ratio, low_ratio);
+        }
+        qsort(up, TPM_LATENCY_REPETITIONS, sizeof(double), TPM_power_compare_double);
+        qsort(down, TPM_LATENCY_REPETITIONS, sizeof(double), TPM_power_compare_double);
+        latency_up[cpu] = up[TPM_LATENCY_REPETITIONS / 2];
+        latency_down[cpu] = down[TPM_LATENCY_REPETITIONS / 2];
+
+        TPM_power_set_frequency(cpu, high_frequency);
+        if (probe.msr_fd >= 0)
+            close(probe.msr_fd);
+    }
+
+    sched_setaffinity(0, sizeof(cpu_set_t), &original_mask);
+    return ncpus;
+}
+
+void TPM_power_dump_latency(const char *filename, int ncpus)
+{
+    FILE *file = fopen(filename, "w");
+    if (file == NULL)
+    {
+        fprintf(stderr, "fopen failed\n");
+        exit(EXIT_FAILURE);
+    }
+    fprintf(file, "cpu,latency_up_us,latency_down_us\n");
+    for (int cpu = 0; cpu < ncpus; cpu++)
+    {
+        fprintf(file, "%d,%f,%f\n", cpu, latency_up[cpu] * 1e6, latency_down[cpu] * 1e6);
+    }
+    fclose(file);
+}
+
+/* Returns the number of CPUs read, 0 if there is no previous calibration */
+int TPM_power_load_latency(const char *filename)
+{
+    FILE *file = fopen(filename, "r");
+    if (file == NULL)
+        return 0;
+
+    char line[128];
+    int ncpus = 0;
+    int cpu;
+    double up, down;
+    while (fgets(line, sizeof(line), file))
+    {
+        if (sscanf(line, "%d,%lf,%lf", &cpu, &up, &down) == 3 && cpu >= 0 && cpu < MAX_CPUS)
+        {
+            latency_up[cpu] = up / 1e6;
+            latency_down[cpu] = down / 1e6;
+            ncpus++;
+        }
+    }
+    fclose(file);
+    return ncpus;
+}
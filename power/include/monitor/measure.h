@@ -38,10 +38,23 @@ void TPM_power_finish_measuring_uj(int active_packages,
 
 void TPM_power_set_frequency(unsigned int cpu, unsigned long frequency)
 {
+    if (TPM_SIMULATED)
+    {
+        TPM_power_sim_set_frequency(cpu, frequency);
+        return;
+    }
     int ret = cpufreq_modify_policy_max(cpu, frequency);
     if (ret != 0)
     {
         fprintf(stderr, "Couldn't set frequency, check root access\n");
         exit(EXIT_FAILURE);
     }
+}
+
+/* Kernel view of the current frequency */
+unsigned long TPM_power_get_frequency(unsigned int cpu)
+{
+    if (TPM_SIMULATED)
+        return TPM_power_sim_get_frequency(cpu, TPM_power_now());
+    return cpufreq_get_freq_kernel(cpu);
 }
\ No newline at end of file
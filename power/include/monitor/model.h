@@ -0,0 +1,396 @@
+/* Tree ensemble exported by ml/learning/export.py, predicting the normalized
+ * target (edp, energy or time) of a power case from the features the
+ * training uses. Scaling and normalization are folded into the thresholds at
+ * export, so the features are evaluated on raw values */
+#define TPM_MODEL_MAX_FEATURES 32
+#define TPM_MODEL_MAX_EVENTS 16
+#define TPM_MODEL_NAME_SIZE 32
+
+typedef struct
+{
+    int feature; // -1 for a leaf
+    double threshold;
+    int left;
+    int right;
+    double value;
+} TreeNode;
+
+typedef struct
+{
+    int num_features;
+    char feature_names[TPM_MODEL_MAX_FEATURES][TPM_MODEL_NAME_SIZE];
+    int num_trees;
+    int *tree_roots;
+    int num_nodes;
+    TreeNode *nodes;
+    double base;
+    double scale;
+} TreeModel;
+
+/* Per task counters of the profiling runs, averaged over the counters files
+ * like ml/data_treatment/utils.py does */
+typedef struct
+{
+    int task;
+    int matrix;
+    unsigned long frequency;
+    double weight;
+    int weight_n;
+    double events[TPM_MODEL_MAX_EVENTS];
+    int events_n[TPM_MODEL_MAX_EVENTS];
+} TaskProfile;
+
+TreeModel tree_model;
+char profile_events[TPM_MODEL_MAX_EVENTS][TPM_MODEL_NAME_SIZE];
+int profile_num_events = 0;
+TaskProfile *task_profiles = NULL;
+int num_task_profiles = 0;
+
+void TPM_power_model_load(const char *filename)
+{
+    FILE *file = fopen(filename, "r");
+    if (file == NULL)
+    {
+        fprintf(stderr, "Couldn't open model %s\n", filename);
+        exit(EXIT_FAILURE);
+    }
+
+    int version;
+    if (fscanf(file, " tpm_model %d", &version) != 1 || version != 1)
+    {
+        fprintf(stderr, "Unknown model format in %s\n", filename);
+        exit(EXIT_FAILURE);
+    }
+    if (fscanf(file, " features %d", &tree_model.num_features) != 1 ||
+        tree_model.num_features > TPM_MODEL_MAX_FEATURES)
+    {
+        fprintf(stderr, "Invalid model features in %s\n", filename);
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < tree_model.num_features; i++)
+    {
+        if (fscanf(file, " %31s", tree_model.feature_names[i]) != 1)
+        {
+            fprintf(stderr, "Invalid model features in %s\n", filename);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (fscanf(file, " trees %d %lf %lf", &tree_model.num_trees,
+               &tree_model.base, &tree_model.scale) != 3 ||
+        fscanf(file, " nodes %d", &tree_model.num_nodes) != 1)
+    {
+        fprintf(stderr, "Invalid model trees in %s\n", filename);
+        exit(EXIT_FAILURE);
+    }
+
+    tree_model.tree_roots = (int *)malloc(tree_model.num_trees * sizeof(int));
+    tree_model.nodes = (TreeNode *)malloc(tree_model.num_nodes * sizeof(TreeNode));
+    if (!tree_model.tree_roots || !tree_model.nodes)
+    {
+        fprintf(stderr, "Failed to allocate memory for the model\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* Node indices are global, each tree gives the index of its root */
+    for (int i = 0; i < tree_model.num_trees; i++)
+    {
+        if (fscanf(file, " tree %d", &tree_model.tree_roots[i]) != 1)
+        {
+            fprintf(stderr, "Invalid model trees in %s\n", filename);
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (int i = 0; i < tree_model.num_nodes; i++)
+    {
+        TreeNode *node = &tree_model.nodes[i];
+        if (fscanf(file, " %d %lf %d %d %lf", &node->feature, &node->threshold,
+                   &node->left, &node->right, &node->value) != 5 ||
+            node->feature >= tree_model.num_features ||
+            (node->feature >= 0 && (node->left < 0 || node->left >= tree_model.num_nodes ||
+                                    node->right < 0 || node->right >= tree_model.num_nodes)))
+        {
+            fprintf(stderr, "Invalid model node %d in %s\n", i, filename);
+            exit(EXIT_FAILURE);
+        }
+    }
+    fclose(file);
+}
+
+double TPM_power_model_predict(const double *features)
+{
+    double sum = 0.0;
+    for (int i = 0; i < tree_model.num_trees; i++)
+    {
+        const TreeNode *node = &tree_model.nodes[tree_model.tree_roots[i]];
+        while (node->feature >= 0)
+        {
+            node = &tree_model.nodes[features[node->feature] <= node->threshold
+                                         ? node->left
+                                         : node->right];
+        }
+        sum += node->value;
+    }
+    return tree_model.base + tree_model.scale * sum;
+}
+
+static int TPM_power_profile_event(const char *name, int create)
+{
+    for (int i = 0; i < profile_num_events; i++)
+    {
+        if (!strcmp(profile_events[i], name))
+            return i;
+    }
+    if (!create || profile_num_events == TPM_MODEL_MAX_EVENTS)
+        return -1;
+    snprintf(profile_events[profile_num_events], TPM_MODEL_NAME_SIZE, "%s", name);
+    return profile_num_events++;
+}
+
+static TaskProfile *TPM_power_task_profile(int task, int matrix, unsigned long frequency)
+{
+    for (int i = 0; i < num_task_profiles; i++)
+    {
+        TaskProfile *profile = &task_profiles[i];
+        if (profile->task == task && profile->matrix == matrix && profile->frequency == frequency)
+            return profile;
+    }
+    task_profiles = (TaskProfile *)realloc(task_profiles, (num_task_profiles + 1) * sizeof(TaskProfile));
+    if (!task_profiles)
+    {
+        fprintf(stderr, "Failed to allocate memory for task_profiles\n");
+        exit(EXIT_FAILURE);
+    }
+    TaskProfile *profile = &task_profiles[num_task_profiles++];
+    memset(profile, 0, sizeof(TaskProfile));
+    profile->task = task;
+    profile->matrix = matrix;
+    profile->frequency = frequency;
+    return profile;
+}
+
+/* Read a counters file of the tracer, keeping the rows of the current
+ * algorithm and tile size */
+static void TPM_power_profile_load_file(const char *filename)
+{
+    FILE *file = fopen(filename, "r");
+    if (file == NULL)
+    {
+        fprintf(stderr, "fopen failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    char line[1024];
+    int columns[TPM_MODEL_MAX_EVENTS];
+    int num_columns = 0;
+    if (fgets(line, sizeof(line), file))
+    {
+        /* algorithm,task,matrix_size,tile_size,l3_cache_size,frequency,weight,events... */
+        char *saveptr;
+        char *token = strtok_r(line, ",\n", &saveptr);
+        for (int i = 0; token; i++, token = strtok_r(NULL, ",\n", &saveptr))
+        {
+            if (i >= 7 && num_columns < TPM_MODEL_MAX_EVENTS)
+                columns[num_columns++] = TPM_power_profile_event(token, 1);
+        }
+    }
+
+    while (fgets(line, sizeof(line), file))
+    {
+        char algorithm[TPM_MODEL_NAME_SIZE], task[TPM_STRING_SIZE];
+        int matrix, tile, consumed;
+        long l3_cache_size;
+        unsigned long frequency;
+        double weight;
+        if (sscanf(line, "%31[^,],%9[^,],%d,%d,%ld,%lu,%lf%n", algorithm, task,
+                   &matrix, &tile, &l3_cache_size, &frequency, &weight, &consumed) != 7)
+            continue;
+        int task_index = TPM_power_task_index(task);
+        if (strcmp(algorithm, ALGORITHM) != 0 || tile != TILE || task_index < 0)
+            continue;
+
+        TaskProfile *profile = TPM_power_task_profile(task_index, matrix, frequency);
+        profile->weight += weight;
+        profile->weight_n++;
+        char *cursor = line + consumed;
+        for (int i = 0; i < num_columns && *cursor == ','; i++)
+        {
+            char *end;
+            double value = strtod(cursor + 1, &end);
+            if (end != cursor + 1 && columns[i] >= 0)
+            {
+                profile->events[columns[i]] += value;
+                profile->events_n[columns[i]]++;
+            }
+            cursor = end;
+        }
+    }
+    fclose(file);
+}
+
+/* Load every counters_*.csv of a folder */
+void TPM_power_profile_load(const char *folder)
+{
+    char pattern[PATH_MAX];
+    snprintf(pattern, sizeof(pattern), "%s/counters_*.csv", folder);
+    glob_t files;
+    if (glob(pattern, 0, NULL, &files) != 0)
+    {
+        fprintf(stderr, "No counters files in %s\n", folder);
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < files.gl_pathc; i++)
+    {
+        TPM_power_profile_load_file(files.gl_pathv[i]);
+    }
+    globfree(&files);
+}
+
+static double TPM_power_profile_mean(const TaskProfile *profile, const char *event)
+{
+    int i = TPM_power_profile_event(event, 0);
+    if (i < 0 || profile->events_n[i] == 0)
+        return 0.0;
+    return profile->events[i] / profile->events_n[i];
+}
+
+static double TPM_power_ratio(double numerator, double denominator)
+{
+    return denominator != 0.0 ? numerator / denominator : 0.0;
+}
+
+/* Metrics of ml/data_treatment/utils.py calculate_new_columns. PAPI_L2_TCW
+ * and PAPI_L3_TCW stay raw, their divisor is folded in the model */
+static double TPM_power_task_metric(const TaskProfile *profile, const char *name)
+{
+    double instructions = TPM_power_profile_mean(profile, "PAPI_TOT_INS");
+    double cycles = TPM_power_profile_mean(profile, "PAPI_TOT_CYC");
+
+    if (!strcmp(name, "ilp"))
+        return TPM_power_ratio(instructions, cycles);
+    if (!strcmp(name, "cpi"))
+        return TPM_power_ratio(cycles, instructions);
+    if (!strcmp(name, "cmr"))
+        return TPM_power_ratio(TPM_power_profile_mean(profile, "PAPI_L3_TCM"),
+                               TPM_power_profile_mean(profile, "PAPI_L3_TCR"));
+    if (!strcmp(name, "vr"))
+        return TPM_power_ratio(TPM_power_profile_mean(profile, "PAPI_VEC_DP"), instructions);
+    if (!strcmp(name, "scr"))
+        return TPM_power_ratio(TPM_power_profile_mean(profile, "PAPI_RES_STL"), cycles);
+    if (!strcmp(name, "PAPI_L2_TCW") || !strcmp(name, "PAPI_L3_TCW") ||
+        !strcmp(name, "PAPI_TOT_INS") || !strcmp(name, "PAPI_TOT_CYC"))
+        return TPM_power_profile_mean(profile, name);
+    if (!strncmp(name, "PAPI_", 5))
+        return TPM_power_ratio(TPM_power_profile_mean(profile, name), instructions);
+
+    fprintf(stderr, "Unknown model feature %s\n", name);
+    exit(EXIT_FAILURE);
+}
+
+/* Features of a case, as built by ml/data_treatment/merge.py: the metrics of
+ * each task at the frequency the case runs it, weighted by its share of the
+ * tasks */
+static void TPM_power_case_features(int selected_case, int matrix,
+                                    unsigned long low_frequency,
+                                    unsigned long high_frequency,
+                                    double *features)
+{
+    double total[2] = {0.0, 0.0};
+    for (int i = 0; i < num_task_profiles; i++)
+    {
+        const TaskProfile *profile = &task_profiles[i];
+        if (profile->matrix == matrix && profile->weight_n > 0 &&
+            (profile->frequency == low_frequency || profile->frequency == high_frequency))
+            total[profile->frequency == high_frequency] += profile->weight / profile->weight_n;
+    }
+
+    for (int f = 0; f < tree_model.num_features; f++)
+    {
+        const char *name = tree_model.feature_names[f];
+        if (!strcmp(name, "number_of_tasks"))
+            features[f] = total[1];
+        else if (!strcmp(name, "matrix_size"))
+            features[f] = MATRIX;
+        else if (!strcmp(name, "tile_size"))
+            features[f] = TILE;
+        else if (!strcmp(name, "case"))
+            features[f] = selected_case;
+        else
+            features[f] = 0.0;
+    }
+
+    for (int task = 0; task < num_tasks; task++)
+    {
+        int low = selected_case == (1 << num_tasks) || ((selected_case - 1) & (1 << task));
+        unsigned long frequency = low ? low_frequency : high_frequency;
+        const TaskProfile *profile = NULL;
+        for (int i = 0; i < num_task_profiles && !profile; i++)
+        {
+            if (task_profiles[i].task == task && task_profiles[i].matrix == matrix &&
+                task_profiles[i].frequency == frequency)
+                profile = &task_profiles[i];
+        }
+        if (!profile || profile->weight_n == 0 || total[!low] == 0.0)
+            continue;
+
+        double weight = profile->weight / profile->weight_n / total[!low];
+        for (int f = 0; f < tree_model.num_features; f++)
+        {
+            const char *name = tree_model.feature_names[f];
+            if (!strcmp(name, "frequency"))
+                features[f] += weight * frequency;
+            else if (strcmp(name, "number_of_tasks") && strcmp(name, "matrix_size") &&
+                     strcmp(name, "tile_size") && strcmp(name, "case"))
+                features[f] += weight * TPM_power_task_metric(profile, name);
+        }
+    }
+}
+
+/* Evaluate every case and return the one with the lowest predicted target.
+ * The profile closest in matrix size to the current run is used */
+int TPM_power_model_select(const char *model_file, const char *counters_folder)
+{
+    TPM_power_model_load(model_file);
+    TPM_power_profile_load(counters_folder);
+    if (num_task_profiles == 0)
+    {
+        fprintf(stderr, "No counters for %s with tile size %d\n", ALGORITHM, TILE);
+        exit(EXIT_FAILURE);
+    }
+
+    int matrix = task_profiles[0].matrix;
+    unsigned long low_frequency = task_profiles[0].frequency;
+    unsigned long high_frequency = task_profiles[0].frequency;
+    for (int i = 1; i < num_task_profiles; i++)
+    {
+        if (abs(task_profiles[i].matrix - MATRIX) < abs(matrix - MATRIX))
+            matrix = task_profiles[i].matrix;
+        low_frequency = task_profiles[i].frequency < low_frequency ? task_profiles[i].frequency : low_frequency;
+        high_frequency = task_profiles[i].frequency > high_frequency ? task_profiles[i].frequency : high_frequency;
+    }
+
+    double start = TPM_power_now();
+    int best_case = 1;
+    double best_prediction = 0.0;
+    double features[TPM_MODEL_MAX_FEATURES];
+    for (int selected_case = 1; selected_case <= (1 << num_tasks); selected_case++)
+    {
+        TPM_power_case_features(selected_case, matrix, low_frequency, high_frequency, features);
+        double prediction = TPM_power_model_predict(features);
+        if (selected_case == 1 || prediction < best_prediction)
+        {
+            best_case = selected_case;
+            best_prediction = prediction;
+        }
+    }
+    double elapsed = TPM_power_now() - start;
+
+    printf("Model selected case %d (predicted %f) out of %d, using the counters of size %d, in %.1f us\n",
+           best_case, best_prediction, 1 << num_tasks, matrix, elapsed * 1e6);
+
+    free(tree_model.tree_roots);
+    free(tree_model.nodes);
+    free(task_profiles);
+    task_profiles = NULL;
+    num_task_profiles = 0;
+    return best_case;
+}
@@ -1,65 +1,363 @@
+/* The daemon is split in stages connected by lock-free queues:
+ * - receive (calling thread): drains the ZMQ socket into the message queue,
+ *   woken up by epoll on the socket file descriptor
+ * - decision: parses the messages, learns the task durations, applies the
+ *   power policy and answers the queries
+ * - actuation: one worker per package doing the frequency writes */
+#define TPM_MESSAGE_QUEUE_SIZE (1 << 16)
+#define TPM_NOTIFY_BATCH 64 // Messages received before waking up the decision stage
+#define TPM_DECISION_TICK 256 // Messages handled between two refreshes of the stats
 
-void TPM_power_monitor(int combination_of_tasks,
-                       int frequency_to_set,
-                       int default_frequency)
+typedef struct
 {
-    TPM_power_start_zmq_server();
+    int size;
+    char message[TPM_MESSAGE_SIZE + 2];
+} RawMessage;
 
-    int active_packages = TPM_rapl_init();
+typedef struct
+{
+    SPSCQueue messages;
+    int stop_fd; // Written by the decision stage once the run is over
+    int combination_of_tasks;
+    int frequency_to_set;
+    int default_frequency;
+    int active_packages;
+    const char **list_of_tasks;
+    uint64_t *pkg_energy_start;
+    uint64_t *pkg_energy_finish;
+    uint64_t *dram_energy_start;
+    uint64_t *dram_energy_finish;
+    uint64_t *pkg_energy_total; // Sum over the closed windows
+    uint64_t *dram_energy_total;
+    int energy_window; // Open between "energy 0" and "energy 1"
+    double exec_time;
+    char *query_reply;
+} MonitorPipeline;
 
-    uint64_t *pkg_energy_start = (uint64_t *)calloc(active_packages, sizeof(uint64_t));
-    uint64_t *pkg_energy_finish = (uint64_t *)calloc(active_packages, sizeof(uint64_t));
-    uint64_t *dram_energy_start = (uint64_t *)calloc(active_packages, sizeof(uint64_t));
-    uint64_t *dram_energy_finish = (uint64_t *)calloc(active_packages, sizeof(uint64_t));
+static int TPM_power_zmq_fd(void *socket)
+{
+    int fd;
+    size_t size = sizeof(fd);
+    if (zmq_getsockopt(socket, ZMQ_FD, &fd, &size) != 0)
+    {
+        fprintf(stderr, "Failed to get the ZMQ file descriptor\n");
+        exit(EXIT_FAILURE);
+    }
+    return fd;
+}
 
-    double exec_time = 0.0;
-    const char **list_of_tasks;
+/* ZMQ file descriptors are edge triggered, the socket has to be asked
+ * whether more messages are pending before waiting again */
+static int TPM_power_zmq_readable(void *socket)
+{
+    int events = 0;
+    size_t size = sizeof(events);
+    zmq_getsockopt(socket, ZMQ_EVENTS, &events, &size);
+    return events & ZMQ_POLLIN;
+}
 
-    while (1)
+static void TPM_power_epoll_add(int epoll_fd, int fd, uint32_t events)
+{
+    struct epoll_event event = {0};
+    event.events = events;
+    event.data.fd = fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0)
     {
-        char received_message[TPM_MESSAGE_SIZE];
-        char key[TPM_STRING_SIZE];
-        double value = 0.0;
+        fprintf(stderr, "epoll_ctl failed\n");
+        exit(EXIT_FAILURE);
+    }
+}
 
-        zmq_recv(zmq_server, received_message, TPM_MESSAGE_SIZE, 0);
-        sscanf(received_message, "%s %lf", key, &value);
+static void TPM_power_serve_queries(MonitorPipeline *pipeline)
+{
+    do
+    {
+        char query[TPM_MESSAGE_SIZE + 1];
+        int size;
+        while ((size = zmq_recv(zmq_query, query, TPM_MESSAGE_SIZE, ZMQ_DONTWAIT)) >= 0)
+        {
+            query[size < TPM_MESSAGE_SIZE ? size : TPM_MESSAGE_SIZE] = '\0';
+            int length = TPM_power_estimator_query(query, pipeline->list_of_tasks,
+                                                   pipeline->query_reply, TPM_QUERY_REPLY_SIZE);
+            zmq_send(zmq_query, pipeline->query_reply, length, 0);
+        }
+    } while (TPM_power_zmq_readable(zmq_query));
+}
 
-        if (strcmp(key, "energy") == 0)
+/* Messages are "energy 0|1", "time seconds", "task cpu" at a task start and
+ * "task cpu f duration_us" at its finish. Returns 1 at the end of the run.
+ * An application repeating its run opens and closes one energy window per
+ * measured repetition, and the energy reported is their sum */
+static int TPM_power_handle_message(MonitorPipeline *pipeline, RawMessage *raw, double now)
+{
+    char *message = raw->message;
+    message[raw->size < TPM_MESSAGE_SIZE ? raw->size : TPM_MESSAGE_SIZE] = '\0';
+
+    char key[TPM_STRING_SIZE];
+    int length = 0;
+    while (message[length] && message[length] != ' ' && length < TPM_STRING_SIZE - 1)
+    {
+        key[length] = message[length];
+        length++;
+    }
+    key[length] = '\0';
+    char *cursor = message + length;
+    double value = strtod(cursor, &cursor);
+    while (*cursor == ' ')
+        cursor++;
+    int finished = *cursor == 'f';
+    double duration = -1.0;
+    if (finished)
+    {
+        char *end;
+        double duration_us = strtod(cursor + 1, &end);
+        if (end != cursor + 1)
+            duration = duration_us / 1e6;
+    }
+
+    if (strcmp(key, "energy") == 0)
+    {
+        if ((unsigned int)value == 0)
         {
-            if ((unsigned int)value == 0)
-            {
-                TPM_power_start_measuring_uj(active_packages,
-                                             pkg_energy_start,
-                                             dram_energy_start);
-            }
-            else if ((unsigned int)value == 1)
+            TPM_power_start_measuring_uj(pipeline->active_packages,
+                                         pipeline->pkg_energy_start,
+                                         pipeline->dram_energy_start);
+            pipeline->energy_window = 1;
+        }
+        else if ((unsigned int)value == 1 && pipeline->energy_window)
+        {
+            TPM_power_finish_measuring_uj(pipeline->active_packages,
+                                          pipeline->pkg_energy_finish,
+                                          pipeline->dram_energy_finish,
+                                          pipeline->pkg_energy_start,
+                                          pipeline->dram_energy_start);
+            for (int i = 0; i < pipeline->active_packages; i++)
             {
-                TPM_power_finish_measuring_uj(active_packages,
-                                              pkg_energy_finish,
-                                              dram_energy_finish,
-                                              pkg_energy_start,
-                                              dram_energy_start);
+                pipeline->pkg_energy_total[i] += pipeline->pkg_energy_finish[i] -
+                                                 pipeline->pkg_energy_start[i];
+                pipeline->dram_energy_total[i] += pipeline->dram_energy_finish[i] -
+                                                  pipeline->dram_energy_start[i];
             }
+            pipeline->energy_window = 0;
         }
-        else if (strcmp(key, "time") == 0)
+    }
+    else if (strcmp(key, "time") == 0)
+    {
+        pipeline->exec_time = value;
+        return 1;
+    }
+    else
+    {
+        int task = TPM_power_task_index(key);
+        unsigned int cpu = (unsigned int)value;
+        if (finished)
         {
-            exec_time = value;
-            break;
+            TPM_power_task_finished(task, cpu, now, duration);
+            TPM_power_control_release(task, cpu);
+            if (task >= 0 && task < TPM_STATS_MAX_TASKS)
+                TPM_power_stats_add(&stats->tasks_finished[task], 1);
         }
         else
         {
-            list_of_tasks = TPM_power_control(combination_of_tasks, key,
-                                              (unsigned int)value, frequency_to_set,
-                                              default_frequency);
+            TPM_power_control(pipeline->combination_of_tasks, task, cpu,
+                              pipeline->frequency_to_set, pipeline->default_frequency);
+            TPM_power_task_started(task, cpu, now,
+                                   cpu < MAX_CPUS ? current_frequency[cpu] : 0);
+            if (task >= 0 && task < TPM_STATS_MAX_TASKS)
+                TPM_power_stats_add(&stats->tasks_started[task], 1);
+        }
+    }
+    return 0;
+}
+
+/* Refresh the stats page, and sample the packages when the stats timer has
+ * expired: the timer is non blocking, so that this is also done between
+ * messages, the queue never getting empty under a sustained stream */
+static void TPM_power_decision_tick(MonitorPipeline *pipeline, int timer_fd, double now)
+{
+    TPM_power_stats_set_double(&stats->updated, now);
+    uint64_t expirations;
+    if (read(timer_fd, &expirations, sizeof(expirations)) > 0)
+        TPM_power_sample_packages(now);
+    TPM_power_serve_queries(pipeline);
+}
+
+static void *TPM_power_decision_run(void *arg)
+{
+    MonitorPipeline *pipeline = (MonitorPipeline *)arg;
+
+    /* Wake up at least every TPM_STATS_PERIOD to keep the stats fresh */
+    int timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    struct itimerspec period = {{TPM_STATS_PERIOD / 1000, (TPM_STATS_PERIOD % 1000) * 1000000},
+                                {TPM_STATS_PERIOD / 1000, (TPM_STATS_PERIOD % 1000) * 1000000}};
+    timerfd_settime(timer_fd, 0, &period, NULL);
+
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    TPM_power_epoll_add(epoll_fd, pipeline->messages.eventfd, EPOLLIN);
+    TPM_power_epoll_add(epoll_fd, TPM_power_zmq_fd(zmq_query), EPOLLIN | EPOLLET);
+    TPM_power_epoll_add(epoll_fd, timer_fd, EPOLLIN);
+
+    int done = 0;
+    uint64_t handled = 0;
+    while (!done)
+    {
+        RawMessage *raw;
+        while (!done && (raw = (RawMessage *)TPM_power_queue_front(&pipeline->messages)) != NULL)
+        {
+            double now = TPM_power_now();
+            done = TPM_power_handle_message(pipeline, raw, now);
+            TPM_power_queue_release(&pipeline->messages);
+            if (!done && ++handled % TPM_DECISION_TICK == 0)
+                TPM_power_decision_tick(pipeline, timer_fd, now);
         }
+        if (done)
+            break;
+
+        TPM_power_serve_queries(pipeline);
+        if (!TPM_power_queue_prepare_wait(&pipeline->messages))
+            continue;
+
+        struct epoll_event events[3];
+        epoll_wait(epoll_fd, events, 3, -1);
+        TPM_power_decision_tick(pipeline, timer_fd, TPM_power_now());
+        TPM_power_queue_woken(&pipeline->messages);
+    }
+
+    close(epoll_fd);
+    close(timer_fd);
+
+    uint64_t one = 1;
+    if (write(pipeline->stop_fd, &one, sizeof(one)) != sizeof(one))
+    {
+        fprintf(stderr, "Failed to stop the receive stage\n");
+        exit(EXIT_FAILURE);
     }
+    return NULL;
+}
+
+/* Receive stage, until the decision stage has seen the end of the run */
+static void TPM_power_receive(MonitorPipeline *pipeline)
+{
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    TPM_power_epoll_add(epoll_fd, TPM_power_zmq_fd(zmq_server), EPOLLIN | EPOLLET);
+    TPM_power_epoll_add(epoll_fd, pipeline->stop_fd, EPOLLIN);
+
+    int running = 1;
+    while (running)
+    {
+        uint64_t received = 0;
+        while (1)
+        {
+            RawMessage *raw = (RawMessage *)TPM_power_queue_reserve(&pipeline->messages);
+            raw->size = zmq_recv(zmq_server, raw->message, TPM_MESSAGE_SIZE, ZMQ_DONTWAIT);
+            if (raw->size < 0)
+                break;
+            TPM_power_queue_commit(&pipeline->messages);
+            if (++received % TPM_NOTIFY_BATCH == 0)
+                TPM_power_queue_notify(&pipeline->messages);
+        }
+        if (received)
+        {
+            TPM_power_queue_notify(&pipeline->messages);
+            TPM_power_stats_add(&stats->messages, received);
+        }
+        if (TPM_power_zmq_readable(zmq_server))
+            continue;
+
+        struct epoll_event events[2];
+        int n = epoll_wait(epoll_fd, events, 2, -1);
+        for (int i = 0; i < n; i++)
+        {
+            if (events[i].data.fd == pipeline->stop_fd)
+                running = 0;
+        }
+    }
+    close(epoll_fd);
+}
+
+void TPM_power_monitor(int combination_of_tasks,
+                       int frequency_to_set,
+                       int default_frequency)
+{
+    const char **list_of_tasks = TPM_power_control_init();
+
+    /* Transition latencies are needed to decide which changes are worth it */
+    if (TPM_HYSTERESIS > 0 && TPM_power_load_latency(TPM_LATENCY_FILE) == 0)
+    {
+        int ncpus = TPM_power_calibrate_latency(frequency_to_set, default_frequency);
+        TPM_power_dump_latency(TPM_LATENCY_FILE, ncpus);
+    }
+
+    int active_packages = TPM_rapl_init();
+    TPM_power_stats_init(active_packages, list_of_tasks, combination_of_tasks);
+
+    TPM_power_estimator_init(list_of_tasks, num_tasks, active_packages);
+    if (TPM_ESTIMATES_FILE)
+        TPM_power_estimator_load(TPM_ESTIMATES_FILE, list_of_tasks);
+
+    TPM_power_start_zmq_server();
+    TPM_power_start_query_server();
+
+    MonitorPipeline pipeline;
+    memset(&pipeline, 0, sizeof(pipeline));
+    TPM_power_queue_init(&pipeline.messages, TPM_MESSAGE_QUEUE_SIZE, sizeof(RawMessage));
+    pipeline.stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    pipeline.combination_of_tasks = combination_of_tasks;
+    pipeline.frequency_to_set = frequency_to_set;
+    pipeline.default_frequency = default_frequency;
+    pipeline.active_packages = active_packages;
+    pipeline.list_of_tasks = list_of_tasks;
+    pipeline.pkg_energy_start = (uint64_t *)calloc(active_packages, sizeof(uint64_t));
+    pipeline.pkg_energy_finish = (uint64_t *)calloc(active_packages, sizeof(uint64_t));
+    pipeline.dram_energy_start = (uint64_t *)calloc(active_packages, sizeof(uint64_t));
+    pipeline.dram_energy_finish = (uint64_t *)calloc(active_packages, sizeof(uint64_t));
+    pipeline.pkg_energy_total = (uint64_t *)calloc(active_packages, sizeof(uint64_t));
+    pipeline.dram_energy_total = (uint64_t *)calloc(active_packages, sizeof(uint64_t));
+    pipeline.query_reply = (char *)malloc(TPM_QUERY_REPLY_SIZE);
+    if (pipeline.stop_fd < 0 || !pipeline.query_reply)
+    {
+        fprintf(stderr, "Failed to allocate the monitor pipeline\n");
+        exit(EXIT_FAILURE);
+    }
+
+    TPM_power_actuation_start();
+    pthread_t decision;
+    if (pthread_create(&decision, NULL, TPM_power_decision_run, &pipeline) != 0)
+    {
+        fprintf(stderr, "Couldn't start the decision stage\n");
+        exit(EXIT_FAILURE);
+    }
+
+    TPM_power_receive(&pipeline);
+
+    pthread_join(decision, NULL);
+    TPM_power_actuation_stop();
+
+    TPM_power_close_query_server();
     TPM_power_close_zmq_server();
-    dump(active_packages, pkg_energy_start, pkg_energy_finish,
-         dram_energy_start, dram_energy_finish,
-         exec_time, list_of_tasks);
-
-    free(pkg_energy_start);
-    free(pkg_energy_finish);
-    free(dram_energy_start);
-    free(dram_energy_finish);
-}
\ No newline at end of file
+    /* All the windows, as a single one */
+    for (int i = 0; i < active_packages; i++)
+    {
+        pipeline.pkg_energy_start[i] = 0;
+        pipeline.pkg_energy_finish[i] = pipeline.pkg_energy_total[i];
+        pipeline.dram_energy_start[i] = 0;
+        pipeline.dram_energy_finish[i] = pipeline.dram_energy_total[i];
+    }
+    dump(active_packages, pipeline.pkg_energy_start, pipeline.pkg_energy_finish,
+         pipeline.dram_energy_start, pipeline.dram_energy_finish,
+         pipeline.exec_time, list_of_tasks);
+
+    TPM_power_estimator_dump(list_of_tasks);
+    TPM_power_estimator_finalize();
+    TPM_power_stats_finalize();
+    TPM_power_queue_finalize(&pipeline.messages);
+    close(pipeline.stop_fd);
+    free(pipeline.query_reply);
+    free(list_of_tasks);
+    free(pipeline.pkg_energy_start);
+    free(pipeline.pkg_energy_finish);
+    free(pipeline.dram_energy_start);
+    free(pipeline.dram_energy_finish);
+    free(pipeline.pkg_energy_total);
+    free(pipeline.dram_energy_total);
+}
@@ -0,0 +1,117 @@
+/* Lock-free single producer, single consumer ring of fixed size slots
+ * connecting the daemon stages. The producer owns tail and the consumer owns
+ * head. A consumer with nothing to do raises sleeping and waits on the
+ * eventfd, which the producer only writes when it sees the flag */
+#define TPM_CACHE_LINE 64
+
+typedef struct
+{
+    uint64_t head __attribute__((aligned(TPM_CACHE_LINE)));
+    uint64_t tail __attribute__((aligned(TPM_CACHE_LINE)));
+    int sleeping __attribute__((aligned(TPM_CACHE_LINE)));
+    int eventfd;
+    uint64_t mask;
+    size_t slot_size;
+    char *slots;
+} SPSCQueue;
+
+void TPM_power_queue_init(SPSCQueue *queue, size_t capacity, size_t slot_size)
+{
+    if (capacity & (capacity - 1))
+    {
+        fprintf(stderr, "Queue capacity must be a power of two\n");
+        exit(EXIT_FAILURE);
+    }
+    queue->head = 0;
+    queue->tail = 0;
+    queue->sleeping = 0;
+    queue->mask = capacity - 1;
+    queue->slot_size = slot_size;
+    queue->slots = (char *)aligned_alloc(TPM_CACHE_LINE, capacity * slot_size);
+    queue->eventfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (!queue->slots || queue->eventfd < 0)
+    {
+        fprintf(stderr, "Failed to allocate queue\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void TPM_power_queue_finalize(SPSCQueue *queue)
+{
+    close(queue->eventfd);
+    free(queue->slots);
+}
+
+/* Producer: next free slot, waiting for the consumer while the ring is full */
+static inline void *TPM_power_queue_reserve(SPSCQueue *queue)
+{
+    uint64_t tail = queue->tail;
+    while (tail - __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE) > queue->mask)
+        sched_yield();
+    return queue->slots + (tail & queue->mask) * queue->slot_size;
+}
+
+static inline void TPM_power_queue_commit(SPSCQueue *queue)
+{
+    __atomic_store_n(&queue->tail, queue->tail + 1, __ATOMIC_RELEASE);
+}
+
+/* Producer: wake the consumer up if it is waiting, once per batch */
+static inline void TPM_power_queue_notify(SPSCQueue *queue)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&queue->sleeping, __ATOMIC_RELAXED))
+    {
+        uint64_t one = 1;
+        if (write(queue->eventfd, &one, sizeof(one)) != sizeof(one))
+        {
+            fprintf(stderr, "Failed to wake up a stage\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+static inline void TPM_power_queue_push(SPSCQueue *queue, const void *item)
+{
+    memcpy(TPM_power_queue_reserve(queue), item, queue->slot_size);
+    TPM_power_queue_commit(queue);
+}
+
+/* Consumer: oldest slot, NULL when empty. Release it once consumed */
+static inline void *TPM_power_queue_front(SPSCQueue *queue)
+{
+    if (queue->head == __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE))
+        return NULL;
+    return queue->slots + (queue->head & queue->mask) * queue->slot_size;
+}
+
+static inline void TPM_power_queue_release(SPSCQueue *queue)
+{
+    __atomic_store_n(&queue->head, queue->head + 1, __ATOMIC_RELEASE);
+}
+
+/* Consumer: announce that it is about to wait. Returns 0 if items arrived
+ * meanwhile, in which case it must not wait */
+static inline int TPM_power_queue_prepare_wait(SPSCQueue *queue)
+{
+    __atomic_store_n(&queue->sleeping, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (queue->head != __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE))
+    {
+        __atomic_store_n(&queue->sleeping, 0, __ATOMIC_RELAXED);
+        return 0;
+    }
+    return 1;
+}
+
+/* Consumer: after waking up, whatever the reason */
+static inline void TPM_power_queue_woken(SPSCQueue *queue)
+{
+    uint64_t count;
+    __atomic_store_n(&queue->sleeping, 0, __ATOMIC_RELAXED);
+    if (read(queue->eventfd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+    {
+        fprintf(stderr, "Failed to read a stage eventfd\n");
+        exit(EXIT_FAILURE);
+    }
+}
@@ -38,7 +38,7 @@ int TPM_rapl_init()
 
     for (int i = 0; i < MAX_PKGS; i++)
     {
-        snprintf(fn, sizeof(fn), "%s/intel-rapl:%d/name", SYSFS_RAPL_DIR, i);
+        snprintf(fn, sizeof(fn), "%s%s/intel-rapl:%d/name", TPM_SYSFS_ROOT, SYSFS_RAPL_DIR, i);
         if (access(fn, R_OK) == 0)
         {
             const char *s = read_string(fn);
@@ -46,21 +46,21 @@ int TPM_rapl_init()
             if (rc == 0)
             {
                 int pkgid = atoi(s + pm[1].rm_so);
-                snprintf(fn, sizeof(fn), "%s/intel-rapl:%d/energy_uj", SYSFS_RAPL_DIR,
-                         i);
+                snprintf(fn, sizeof(fn), "%s%s/intel-rapl:%d/energy_uj", TPM_SYSFS_ROOT,
+                         SYSFS_RAPL_DIR, i);
                 pkg_energy_uj[pkgid] = strdup(fn);
 
-                snprintf(fn, sizeof(fn), "%s/intel-rapl:%d/max_energy_range_uj",
-                         SYSFS_RAPL_DIR, i);
+                snprintf(fn, sizeof(fn), "%s%s/intel-rapl:%d/max_energy_range_uj",
+                         TPM_SYSFS_ROOT, SYSFS_RAPL_DIR, i);
                 pkg_energy_maxuj[pkgid] = strdup(fn);
 
-                snprintf(fn, sizeof(fn), "%s/intel-rapl:%d/intel-rapl:%d:0/energy_uj",
-                         SYSFS_RAPL_DIR, i, i);
+                snprintf(fn, sizeof(fn), "%s%s/intel-rapl:%d/intel-rapl:%d:0/energy_uj",
+                         TPM_SYSFS_ROOT, SYSFS_RAPL_DIR, i, i);
                 dram_energy_uj[pkgid] = strdup(fn);
 
                 snprintf(fn, sizeof(fn),
-                         "%s/intel-rapl:%d/intel-rapl:%d:0/max_energy_range_uj",
-                         SYSFS_RAPL_DIR, i, i);
+                         "%s%s/intel-rapl:%d/intel-rapl:%d:0/max_energy_range_uj",
+                         TPM_SYSFS_ROOT, SYSFS_RAPL_DIR, i, i);
                 dram_energy_maxuj[pkgid] = strdup(fn);
                 active_packages++;
             }
@@ -96,6 +96,7 @@ uint64_t TPM_rapl_get_maxuj(int pkgid, char *domain)
     if (!s)
         return 3;
     ret = atoll(s);
+    free((void *)s);
     return ret;
 }
 
@@ -119,5 +120,6 @@ uint64_t TPM_rapl_get_uj(int pkgid, char *domain)
     if (!s)
         return 3;
     ret = atoll(s);
+    free((void *)s);
     return ret;
 }
\ No newline at end of file
@@ -0,0 +1,302 @@
+/* Simulated RAPL and cpufreq backend (TPM_POWER_BACKEND=sim). The daemon
+ * builds a fake sysfs tree under TPM_SYSFS_ROOT, with the same layout as
+ * the real one, and a thread advances its energy counters following a
+ * simple power model of the requested frequencies:
+ *   package = static + sum over its CPUs of dynamic * (f / f_max)^alpha
+ * Counters wrap around at max_energy_range_uj like the hardware ones */
+char *TPM_SYSFS_ROOT = "";
+int TPM_SIMULATED = 0;
+
+typedef struct
+{
+    int packages;
+    int cpus;
+    int domain_size; // CPUs sharing a cpufreq policy
+    double static_power;  // Watts per package
+    double dynamic_power; // Watts per CPU at the maximum frequency
+    double alpha;
+    double dram_power; // Watts per package
+    uint64_t range_uj;
+    double period;  // Seconds between two counter updates
+    double latency; // Seconds before a requested frequency is reached
+    unsigned long max_frequency;
+    volatile int running;
+    pthread_t thread;
+    double pkg_energy[MAX_PKGS]; // uJ, not wrapped
+    double dram_energy[MAX_PKGS];
+} SimulatedMachine;
+
+SimulatedMachine sim;
+
+/* Requested frequency per CPU, the one before, and when it was requested */
+unsigned long sim_target[MAX_CPUS];
+unsigned long sim_previous[MAX_CPUS];
+double sim_changed[MAX_CPUS];
+
+/* Simulated APERF, in cycles at the time of the last request */
+double sim_aperf[MAX_CPUS];
+pthread_mutex_t sim_counters_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Write through a temporary file, so that readers never see partial values */
+static void TPM_power_sim_write(const char *path, const char *value)
+{
+    char tmp[PATH_MAX];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *file = fopen(tmp, "w");
+    if (file == NULL)
+    {
+        fprintf(stderr, "Couldn't write simulated %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+    fprintf(file, "%s\n", value);
+    fclose(file);
+    rename(tmp, path);
+}
+
+static void TPM_power_sim_write_u64(const char *path, uint64_t value)
+{
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%" PRIu64, value);
+    TPM_power_sim_write(path, buffer);
+}
+
+static void TPM_power_sim_mkdir(const char *path)
+{
+    char buffer[PATH_MAX];
+    snprintf(buffer, sizeof(buffer), "%s", path);
+    for (char *p = buffer + 1; *p; p++)
+    {
+        if (*p == '/')
+        {
+            *p = '\0';
+            mkdir(buffer, 0755);
+            *p = '/';
+        }
+    }
+    if (mkdir(buffer, 0755) != 0 && errno != EEXIST)
+    {
+        fprintf(stderr, "Couldn't create simulated %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+}
+
+/* Package of a CPU, the one reported in its topology and powering it */
+static int TPM_power_sim_package(int cpu)
+{
+    return cpu * sim.packages / sim.cpus;
+}
+
+/* Frequency the CPU runs at, once the transition latency has elapsed */
+unsigned long TPM_power_sim_get_frequency(unsigned int cpu, double now)
+{
+    if (cpu >= MAX_CPUS)
+        return 0;
+    double changed;
+    __atomic_load(&sim_changed[cpu], &changed, __ATOMIC_ACQUIRE);
+    return now - changed >= sim.latency ? __atomic_load_n(&sim_target[cpu], __ATOMIC_RELAXED)
+                                        : __atomic_load_n(&sim_previous[cpu], __ATOMIC_RELAXED);
+}
+
+/* Cycles since the start at the delivered frequency (kHz) */
+static double TPM_power_sim_aperf(unsigned int cpu, double now)
+{
+    double elapsed = now - sim_changed[cpu];
+    double previous = elapsed < sim.latency ? elapsed : sim.latency;
+    return sim_aperf[cpu] + 1e3 * (previous * sim_previous[cpu] +
+                                   (elapsed - previous) * sim_target[cpu]);
+}
+
+/* Simulated APERF, MPERF and TSC: the TSC and MPERF tick at the maximum
+ * frequency and CPUs never idle */
+int TPM_power_sim_read_counters(unsigned int cpu, uint64_t *aperf, uint64_t *mperf,
+                                uint64_t *tsc)
+{
+    if (cpu >= (unsigned int)sim.cpus)
+        return -1;
+    pthread_mutex_lock(&sim_counters_lock);
+    double now = TPM_power_now();
+    *aperf = (uint64_t)TPM_power_sim_aperf(cpu, now);
+    pthread_mutex_unlock(&sim_counters_lock);
+    *tsc = (uint64_t)(now * 1e3 * sim.max_frequency);
+    *mperf = *tsc;
+    return 0;
+}
+
+/* Like cpufreq, a write through any CPU of a domain moves the whole domain */
+void TPM_power_sim_set_frequency(unsigned int cpu, unsigned long frequency)
+{
+    if (cpu >= (unsigned int)sim.cpus)
+    {
+        fprintf(stderr, "Couldn't set frequency, no simulated CPU %u\n", cpu);
+        exit(EXIT_FAILURE);
+    }
+    unsigned int first = cpu - cpu % sim.domain_size;
+    char path[PATH_MAX];
+    for (unsigned int member = first; member < first + sim.domain_size && member < (unsigned int)sim.cpus; member++)
+    {
+        pthread_mutex_lock(&sim_counters_lock);
+        double now = TPM_power_now();
+        sim_aperf[member] = TPM_power_sim_aperf(member, now);
+        __atomic_store_n(&sim_previous[member], TPM_power_sim_get_frequency(member, now), __ATOMIC_RELAXED);
+        __atomic_store_n(&sim_target[member], frequency, __ATOMIC_RELAXED);
+        __atomic_store(&sim_changed[member], &now, __ATOMIC_RELEASE);
+        pthread_mutex_unlock(&sim_counters_lock);
+
+        snprintf(path, sizeof(path), "%s/sys/devices/system/cpu/cpu%u/cpufreq/scaling_max_freq",
+                 TPM_SYSFS_ROOT, member);
+        TPM_power_sim_write_u64(path, frequency);
+    }
+}
+
+static void *TPM_power_sim_run(void *arg)
+{
+    char path[PATH_MAX];
+    double last = TPM_power_now();
+    struct timespec period = {(time_t)sim.period,
+                              (long)((sim.period - (time_t)sim.period) * 1e9)};
+
+    while (sim.running)
+    {
+        nanosleep(&period, NULL);
+        double now = TPM_power_now();
+        double elapsed = now - last;
+        last = now;
+
+        double power[MAX_PKGS];
+        for (int i = 0; i < sim.packages; i++)
+            power[i] = sim.static_power;
+        for (int cpu = 0; cpu < sim.cpus; cpu++)
+        {
+            double ratio = (double)TPM_power_sim_get_frequency(cpu, now) / sim.max_frequency;
+            power[TPM_power_sim_package(cpu)] += sim.dynamic_power * pow(ratio, sim.alpha);
+        }
+
+        for (int i = 0; i < sim.packages; i++)
+        {
+            sim.pkg_energy[i] += power[i] * elapsed * 1e6;
+            sim.dram_energy[i] += sim.dram_power * elapsed * 1e6;
+
+            snprintf(path, sizeof(path), "%s%s/intel-rapl:%d/energy_uj",
+                     TPM_SYSFS_ROOT, SYSFS_RAPL_DIR, i);
+            TPM_power_sim_write_u64(path, (uint64_t)sim.pkg_energy[i] % sim.range_uj);
+            snprintf(path, sizeof(path), "%s%s/intel-rapl:%d/intel-rapl:%d:0/energy_uj",
+                     TPM_SYSFS_ROOT, SYSFS_RAPL_DIR, i, i);
+            TPM_power_sim_write_u64(path, (uint64_t)sim.dram_energy[i] % sim.range_uj);
+        }
+    }
+    return NULL;
+}
+
+/* Build the tree and start the power model, all CPUs at max_frequency */
+void TPM_power_sim_init(unsigned long max_frequency)
+{
+    TPM_SYSFS_ROOT = TPM_power_getenv_string("TPM_POWER_SIM_DIR", "/tmp/tpm_power_sim");
+    sim.packages = TPM_power_getenv_int("TPM_POWER_SIM_PACKAGES", 1);
+    sim.cpus = TPM_power_getenv_int("TPM_POWER_SIM_CPUS", sysconf(_SC_NPROCESSORS_ONLN));
+    sim.domain_size = TPM_power_getenv_int("TPM_POWER_SIM_DOMAIN", 1);
+    sim.static_power = TPM_power_getenv_double("TPM_POWER_SIM_STATIC", 20.0);
+    sim.dynamic_power = TPM_power_getenv_double("TPM_POWER_SIM_DYNAMIC", 5.0);
+    sim.alpha = TPM_power_getenv_double("TPM_POWER_SIM_ALPHA", 3.0);
+    sim.dram_power = TPM_power_getenv_double("TPM_POWER_SIM_DRAM", 5.0);
+    sim.range_uj = (uint64_t)TPM_power_getenv_double("TPM_POWER_SIM_RANGE", 262143328850.0);
+    sim.period = TPM_power_getenv_double("TPM_POWER_SIM_PERIOD", 0.001);
+    sim.latency = TPM_power_getenv_double("TPM_POWER_SIM_LATENCY", 0.00005);
+    sim.max_frequency = max_frequency;
+    if (sim.packages < 1 || sim.packages > MAX_PKGS || sim.cpus < sim.packages ||
+        sim.cpus > MAX_CPUS || sim.domain_size < 1 || sim.range_uj == 0 || sim.max_frequency == 0)
+    {
+        fprintf(stderr, "Invalid simulated machine\n");
+        exit(EXIT_FAILURE);
+    }
+
+    char path[PATH_MAX];
+    for (int i = 0; i < sim.packages; i++)
+    {
+        snprintf(path, sizeof(path), "%s%s/intel-rapl:%d/intel-rapl:%d:0",
+                 TPM_SYSFS_ROOT, SYSFS_RAPL_DIR, i, i);
+        TPM_power_sim_mkdir(path);
+
+        char name[32];
+        snprintf(name, sizeof(name), "package-%d", i);
+        snprintf(path, sizeof(path), "%s%s/intel-rapl:%d/name", TPM_SYSFS_ROOT, SYSFS_RAPL_DIR, i);
+        TPM_power_sim_write(path, name);
+        snprintf(path, sizeof(path), "%s%s/intel-rapl:%d/intel-rapl:%d:0/name",
+                 TPM_SYSFS_ROOT, SYSFS_RAPL_DIR, i, i);
+        TPM_power_sim_write(path, "dram");
+
+        /* Start half way through the range, so that small ranges wrap early */
+        sim.pkg_energy[i] = sim.range_uj / 2;
+        sim.dram_energy[i] = sim.range_uj / 2;
+        snprintf(path, sizeof(path), "%s%s/intel-rapl:%d/energy_uj", TPM_SYSFS_ROOT, SYSFS_RAPL_DIR, i);
+        TPM_power_sim_write_u64(path, (uint64_t)sim.pkg_energy[i]);
+        snprintf(path, sizeof(path), "%s%s/intel-rapl:%d/max_energy_range_uj",
+                 TPM_SYSFS_ROOT, SYSFS_RAPL_DIR, i);
+        TPM_power_sim_write_u64(path, sim.range_uj);
+        snprintf(path, sizeof(path), "%s%s/intel-rapl:%d/intel-rapl:%d:0/energy_uj",
+                 TPM_SYSFS_ROOT, SYSFS_RAPL_DIR, i, i);
+        TPM_power_sim_write_u64(path, (uint64_t)sim.dram_energy[i]);
+        snprintf(path, sizeof(path), "%s%s/intel-rapl:%d/intel-rapl:%d:0/max_energy_range_uj",
+                 TPM_SYSFS_ROOT, SYSFS_RAPL_DIR, i, i);
+        TPM_power_sim_write_u64(path, sim.range_uj);
+    }
+
+    for (int cpu = 0; cpu < sim.cpus; cpu++)
+    {
+        snprintf(path, sizeof(path), "%s/sys/devices/system/cpu/cpu%d/cpufreq", TPM_SYSFS_ROOT, cpu);
+        TPM_power_sim_mkdir(path);
+        snprintf(path, sizeof(path), "%s/sys/devices/system/cpu/cpu%d/topology", TPM_SYSFS_ROOT, cpu);
+        TPM_power_sim_mkdir(path);
+
+        snprintf(path, sizeof(path), "%s/sys/devices/system/cpu/cpu%d/cpufreq/scaling_governor",
+                 TPM_SYSFS_ROOT, cpu);
+        TPM_power_sim_write(path, "ondemand");
+        snprintf(path, sizeof(path), "%s/sys/devices/system/cpu/cpu%d/topology/physical_package_id",
+                 TPM_SYSFS_ROOT, cpu);
+        TPM_power_sim_write_u64(path, TPM_power_sim_package(cpu));
+
+        char members[PATH_MAX] = {0};
+        int length = 0;
+        int first = cpu - cpu % sim.domain_size;
+        for (int member = first; member < first + sim.domain_size && member < sim.cpus; member++)
+            length += snprintf(members + length, sizeof(members) - length, member > first ? " %d" : "%d", member);
+        snprintf(path, sizeof(path), "%s/sys/devices/system/cpu/cpu%d/cpufreq/related_cpus",
+                 TPM_SYSFS_ROOT, cpu);
+        TPM_power_sim_write(path, members);
+        snprintf(path, sizeof(path), "%s/sys/devices/system/cpu/cpu%d/cpufreq/affected_cpus",
+                 TPM_SYSFS_ROOT, cpu);
+        TPM_power_sim_write(path, members);
+
+        sim_target[cpu] = max_frequency;
+        sim_previous[cpu] = max_frequency;
+        sim_aperf[cpu] = 0.0;
+        sim_changed[cpu] = 0.0;
+        TPM_power_sim_set_frequency(cpu, max_frequency);
+    }
+
+    sim.running = 1;
+    if (pthread_create(&sim.thread, NULL, TPM_power_sim_run, NULL) != 0)
+    {
+        fprintf(stderr, "Couldn't start the simulated machine\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/* Governor of CPU 0 in the simulated tree */
+int TPM_power_sim_governor_is(const char *governor)
+{
+    char path[PATH_MAX], buffer[32] = {0};
+    snprintf(path, sizeof(path), "%s/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor",
+             TPM_SYSFS_ROOT);
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+        return 0;
+    int found = fscanf(file, "%31s", buffer) == 1 && !strcmp(buffer, governor);
+    fclose(file);
+    return found;
+}
+
+void TPM_power_sim_finalize()
+{
+    sim.running = 0;
+    pthread_join(sim.thread, NULL);
+}
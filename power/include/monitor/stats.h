@@ -0,0 +1,115 @@
+/* Live statistics of the daemon, in a shared memory page that monitoring
+ * tools (e.g. TPMstat) can map read-only and scrape at any rate. Fields are
+ * updated with relaxed atomics only, so the control loop never waits on a
+ * reader; each field is consistent on its own, not across fields */
+#define TPM_STATS_MAGIC 0x534d5054 // "TPMS"
+#define TPM_STATS_VERSION 2
+#define TPM_STATS_MAX_TASKS 16
+#define TPM_STATS_PERIOD 1000 // ms, longest time between two updates
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    int32_t pid;
+    int32_t packages;
+    int32_t cpus;
+    int32_t domains; // Frequency domains
+    int32_t num_tasks;
+    int32_t selected_case;
+    int32_t running; // 0 once the daemon has exited
+    double started;  // CLOCK_MONOTONIC seconds
+    double updated;
+    uint64_t messages;
+    uint64_t transitions_issued;
+    uint64_t transitions_skipped;
+    double package_power[MAX_PKGS]; // Watts over the last sampling period
+    uint64_t cpu_frequency[MAX_CPUS]; // Last frequency requested, 0 if none
+    char task_names[TPM_STATS_MAX_TASKS][TPM_STRING_SIZE];
+    uint64_t tasks_started[TPM_STATS_MAX_TASKS];
+    uint64_t tasks_finished[TPM_STATS_MAX_TASKS];
+} TPMStats;
+
+/* Always valid: a private page when the shared one is disabled */
+TPMStats *stats = NULL;
+char *TPM_STATS_NAME;
+
+static inline void TPM_power_stats_add(uint64_t *counter, uint64_t value)
+{
+    __atomic_fetch_add(counter, value, __ATOMIC_RELAXED);
+}
+
+static inline void TPM_power_stats_set(uint64_t *field, uint64_t value)
+{
+    __atomic_store_n(field, value, __ATOMIC_RELAXED);
+}
+
+static inline void TPM_power_stats_set_double(double *field, double value)
+{
+    __atomic_store(field, &value, __ATOMIC_RELAXED);
+}
+
+void TPM_power_stats_init(int active_packages, const char **list_of_tasks,
+                          int selected_case)
+{
+    if (TPM_STATS_NAME && TPM_STATS_NAME[0])
+    {
+        int fd = shm_open(TPM_STATS_NAME, O_CREAT | O_RDWR, 0644);
+        if (fd < 0 || ftruncate(fd, sizeof(TPMStats)) != 0)
+        {
+            fprintf(stderr, "Failed to create the stats page %s\n", TPM_STATS_NAME);
+            exit(EXIT_FAILURE);
+        }
+        stats = (TPMStats *)mmap(NULL, sizeof(TPMStats), PROT_READ | PROT_WRITE,
+                                 MAP_SHARED, fd, 0);
+        close(fd);
+        if (stats == MAP_FAILED)
+        {
+            fprintf(stderr, "Failed to map the stats page %s\n", TPM_STATS_NAME);
+            exit(EXIT_FAILURE);
+        }
+    }
+    else
+    {
+        stats = (TPMStats *)malloc(sizeof(TPMStats));
+        if (!stats)
+        {
+            fprintf(stderr, "Failed to allocate memory for stats\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    memset(stats, 0, sizeof(TPMStats));
+    stats->version = TPM_STATS_VERSION;
+    stats->pid = getpid();
+    stats->packages = active_packages;
+    stats->cpus = domains_count;
+    stats->domains = num_domains;
+    stats->selected_case = selected_case;
+    stats->running = 1;
+    stats->started = TPM_power_now();
+    stats->updated = stats->started;
+    for (int i = 0; list_of_tasks[i] != NULL && i < TPM_STATS_MAX_TASKS; i++)
+    {
+        snprintf(stats->task_names[i], TPM_STRING_SIZE, "%s", list_of_tasks[i]);
+        stats->num_tasks++;
+    }
+    /* Readers check the magic last, once the page is filled */
+    __atomic_store_n(&stats->magic, TPM_STATS_MAGIC, __ATOMIC_RELEASE);
+}
+
+void TPM_power_stats_finalize()
+{
+    if (TPM_STATS_NAME && TPM_STATS_NAME[0])
+    {
+        /* The page is left in place, so that a last scrape sees the final
+         * counters */
+        __atomic_store_n(&stats->running, 0, __ATOMIC_RELEASE);
+        munmap(stats, sizeof(TPMStats));
+    }
+    else
+    {
+        free(stats);
+    }
+    stats = NULL;
+}
@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
@@ -7,18 +8,39 @@
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <unistd.h>
+#include <sched.h>
+#include <time.h>
+#include <math.h>
+#include <glob.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
 
 #include "zmq.h"
 #include "cpufreq.h"
 
 #include "utils.h"
 #include "common.h"
+#include "simulator.h"
 #include "check_governor.h"
 #include "server.h"
 
 #include "rapl.h"
 #include "measure.h"
+#include "domains.h"
+#include "stats.h"
+#include "latency.h"
+#include "cores.h"
+#include "estimator.h"
+#include "queue.h"
+#include "actuation.h"
 #include "dump.h"
 #include "control.h"
+#include "model.h"
 
 #include "monitor.h"
\ No newline at end of file
@@ -24,4 +24,30 @@ void TPM_power_close_zmq_server()
         fprintf(stderr, "Failed to shut down ZMQ server\n");
         exit(EXIT_FAILURE);
     }
-}
\ No newline at end of file
+}
+
+/* Request/reply socket answering the estimator queries */
+void TPM_power_start_query_server()
+{
+    zmq_query = zmq_socket(zmq_context, ZMQ_REP);
+
+    int number = 0;
+    zmq_setsockopt(zmq_query, ZMQ_LINGER, &number, sizeof(int));
+    int ret = zmq_bind(zmq_query, TPM_QUERY_ENDPOINT);
+    if (ret != 0)
+    {
+        fprintf(stderr, "Failed to launch ZMQ query server\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void TPM_power_close_query_server()
+{
+    int ret = zmq_unbind(zmq_query, TPM_QUERY_ENDPOINT);
+    if (ret != 0)
+    {
+        fprintf(stderr, "Failed to shut down ZMQ query server\n");
+        exit(EXIT_FAILURE);
+    }
+    zmq_close(zmq_query);
+}
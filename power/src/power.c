@@ -17,11 +17,52 @@ int main(int argc, char *argv[])
     MATRIX = atoi(getenv("TPM_MATRIX"));
     TILE = atoi(getenv("TPM_TILE"));
 
+    TPM_HYSTERESIS = TPM_power_getenv_double("TPM_POWER_HYSTERESIS", 0.0);
+    TPM_LATENCY_FILE = TPM_power_getenv_string("TPM_POWER_LATENCY_FILE", "frequency_latency.csv");
+    TPM_QUERY_ENDPOINT = TPM_power_getenv_string("TPM_POWER_QUERY_ENDPOINT", "tcp://127.0.0.1:5556");
+    TPM_ESTIMATES_FILE = TPM_power_getenv_string("TPM_POWER_ESTIMATES", NULL);
+    TPM_INSTANCES_FILE = TPM_power_getenv_string("TPM_POWER_INSTANCES", NULL);
+    TPM_STATS_NAME = TPM_power_getenv_string("TPM_POWER_STATS", "/tpm_power_stats");
+
+    /* Simulated RAPL and cpufreq, for testing without privileges */
+    if (!strcmp(TPM_power_getenv_string("TPM_POWER_BACKEND", "sysfs"), "sim"))
+    {
+        TPM_SIMULATED = 1;
+        TPM_power_sim_init(default_frequency);
+    }
+
+    /* Calibration mode: measure the frequency transition latencies and exit */
+    if (TPM_power_getenv_int("TPM_POWER_CALIBRATE", 0))
+    {
+        int ncpus = TPM_power_calibrate_latency(frequency_to_set, default_frequency);
+        TPM_power_dump_latency(TPM_LATENCY_FILE, ncpus);
+        if (TPM_SIMULATED)
+            TPM_power_sim_finalize();
+        return 0;
+    }
+
+    /* Case 0: let the exported model pick the case from the profiled counters */
+    if (combination_of_tasks == 0)
+    {
+        char *model = TPM_power_getenv_string("TPM_POWER_MODEL", NULL);
+        char *counters = TPM_power_getenv_string("TPM_POWER_COUNTERS", NULL);
+        if (model == NULL || counters == NULL)
+        {
+            fprintf(stderr, "Case 0 needs TPM_POWER_MODEL and TPM_POWER_COUNTERS\n");
+            exit(EXIT_FAILURE);
+        }
+        TPM_power_control_init();
+        combination_of_tasks = TPM_power_model_select(model, counters);
+    }
+
     /* Check that the current governor is ondemand */
     TPM_power_check_current_governor();
 
     /* Control power */
     TPM_power_monitor(combination_of_tasks, frequency_to_set, default_frequency);
 
+    if (TPM_SIMULATED)
+        TPM_power_sim_finalize();
+
     return 0;
 }
\ No newline at end of file
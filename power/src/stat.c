@@ -0,0 +1,57 @@
+#include "tpm_power.h"
+
+/* Print a snapshot of the daemon stats page, one metric per line */
+int main(int argc, char *argv[])
+{
+    const char *name = argc > 1 ? argv[1] : TPM_power_getenv_string("TPM_POWER_STATS", "/tpm_power_stats");
+
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0)
+    {
+        fprintf(stderr, "No stats page %s, is TPMpower running?\n", name);
+        exit(EXIT_FAILURE);
+    }
+    const TPMStats *page = (const TPMStats *)mmap(NULL, sizeof(TPMStats), PROT_READ,
+                                                  MAP_SHARED, fd, 0);
+    close(fd);
+    if (page == MAP_FAILED)
+    {
+        fprintf(stderr, "Failed to map the stats page %s\n", name);
+        exit(EXIT_FAILURE);
+    }
+    if (__atomic_load_n(&page->magic, __ATOMIC_ACQUIRE) != TPM_STATS_MAGIC ||
+        page->version != TPM_STATS_VERSION)
+    {
+        fprintf(stderr, "Stats page %s not initialized\n", name);
+        exit(EXIT_FAILURE);
+    }
+
+    printf("tpm_power_up %d\n", page->running);
+    printf("tpm_power_pid %d\n", page->pid);
+    printf("tpm_power_case %d\n", page->selected_case);
+    printf("tpm_power_frequency_domains %d\n", page->domains);
+    printf("tpm_power_uptime_seconds %f\n", page->updated - page->started);
+    printf("tpm_power_last_update_seconds %f\n", TPM_power_now() - page->updated);
+    printf("tpm_power_messages %" PRIu64 "\n", page->messages);
+    printf("tpm_power_transitions_issued %" PRIu64 "\n", page->transitions_issued);
+    printf("tpm_power_transitions_skipped %" PRIu64 "\n", page->transitions_skipped);
+    for (int i = 0; i < page->packages && i < MAX_PKGS; i++)
+    {
+        printf("tpm_power_package_watts{package=\"%d\"} %f\n", i, page->package_power[i]);
+    }
+    for (int i = 0; i < page->cpus && i < MAX_CPUS; i++)
+    {
+        if (page->cpu_frequency[i])
+            printf("tpm_power_cpu_frequency_khz{cpu=\"%d\"} %" PRIu64 "\n", i, page->cpu_frequency[i]);
+    }
+    for (int i = 0; i < page->num_tasks && i < TPM_STATS_MAX_TASKS; i++)
+    {
+        printf("tpm_power_tasks_started{task=\"%.*s\"} %" PRIu64 "\n",
+               TPM_STRING_SIZE, page->task_names[i], page->tasks_started[i]);
+        printf("tpm_power_tasks_finished{task=\"%.*s\"} %" PRIu64 "\n",
+               TPM_STRING_SIZE, page->task_names[i], page->tasks_finished[i]);
+    }
+
+    munmap((void *)page, sizeof(TPMStats));
+    return 0;
+}
@@ -51,10 +51,10 @@ static const char *dlantr_tasks[] = {"laset", "lantr", "lange", "langemax"};
 static const char *dlansy_tasks[] = {"laset", "lansy", "lange", "langemax"};
 static const char *dlange_tasks[] = {"laset", "lange", "langemax"};
 static const char *cholesky_tasks[] = {"potrf", "trsm", "syrk", "gemm"};
-static const char *qr_tasks[] = {"geqrt", "ormqr", "tsmqr", "tsqrt"};
+static const char *qr_tasks[] = {"geqrt", "ormqr", "tsmqr", "tsqrt", "ttqrt", "ttmqr"};
 static const char *lu_tasks[] = {"getrfpiv", "gemm", "trsmswp", "geswp"};
 static const char *sylsvd_tasks[] = {"trsyl", "gesvd", "geev", "gemm"};
-static const char *invert_tasks[] = {"getrf", "gemm", "trsm", "getri"};
+static const char *invert_tasks[] = {"getrfpiv", "gemm", "trsmswp", "geswp", "lacpy", "trsm", "trtri", "colswp"};
 static const char *sparselu_tasks[] = {"lu0", "fwd", "bdiv", "bmod"};
 
 Algorithm algorithms[] = {
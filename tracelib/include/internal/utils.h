@@ -14,6 +14,16 @@ volatile double total_task_time;
 struct timespec start, end;
 struct timespec total_start, total_end;
 
+/* Start of the task running on the calling thread, and the CPU it started
+ * on, for the power daemon */
+__thread struct timespec power_task_start;
+__thread unsigned int power_task_cpu;
+
+/* Frequencies are set per CPU, threads should stay on theirs: 1 refuses to
+ * run unpinned (OMP_PROC_BIND unset or false), 0 only warns */
+int TPM_POWER_PINNING = 0;
+unsigned long power_task_migrations = 0;
+
 int task_counter = 0;
 
 pthread_mutex_t mutex;
\ No newline at end of file
@@ -11,6 +11,10 @@ extern void TPM_trace_task_start(const char *task_name);
 // Capture the end of an OpenMP task region
 extern void TPM_trace_task_finish(const char *task_name);
 
+// Open (1) or close (0) an energy measurement window, around the measured
+// repetitions of an application that runs several times
+extern void TPM_trace_energy(int window);
+
 // End the power control and send the captured application metrics: when the
 // application ends
 extern void TPM_trace_finalize(double total_execution_time);
@@ -32,6 +36,11 @@ extern void TPM_middle_man_task_finish(const char *task_name)
     TPM_trace_task_finish(task_name);
 }
 
+extern void TPM_middle_man_energy(int window)
+{
+    TPM_trace_energy(window);
+}
+
 extern void TPM_middle_man_finalize(double total_execution_time)
 {
     TPM_trace_finalize(total_execution_time);
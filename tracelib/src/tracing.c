@@ -18,6 +18,17 @@ extern void TPM_trace_start()
     /* ZMQ initialization */
     if (TPM_POWER)
     {
+        char *pinning = getenv("TPM_POWER_PINNING");
+        TPM_POWER_PINNING = pinning ? atoi(pinning) : 0;
+        char *bind = getenv("OMP_PROC_BIND");
+        if (bind == NULL || strncasecmp(bind, "false", 5) == 0)
+        {
+            fprintf(stderr, "OMP_PROC_BIND is not set, threads may migrate between CPUs "
+                            "and frequency domains\n");
+            if (TPM_POWER_PINNING)
+                exit(EXIT_FAILURE);
+        }
+
         zmq_context = zmq_ctx_new();
         zmq_request = zmq_socket(zmq_context, ZMQ_PUSH);
 
@@ -138,6 +149,8 @@ extern void TPM_trace_task_start(const char *task_name)
     {
         unsigned int cpu, node;
         getcpu(&cpu, &node);
+        power_task_cpu = cpu;
+        clock_gettime(CLOCK_MONOTONIC, &power_task_start);
         char *signal_control_task_on_cpu = TPM_str_and_int_to_str(task_name, cpu);
         TPM_zmq_send_signal(zmq_request, signal_control_task_on_cpu);
         free(signal_control_task_on_cpu);
@@ -174,6 +187,25 @@ extern void TPM_trace_task_finish(const char *task_name)
         }
     }
 
+    if (TPM_POWER)
+    {
+        /* Lets the power daemon learn the task durations, measured here
+         * since the daemon only sees the messages when it gets scheduled. The
+         * finish is reported on the CPU the task started on */
+        unsigned int cpu, node;
+        getcpu(&cpu, &node);
+        if (cpu != power_task_cpu)
+            power_task_migrations++;
+        struct timespec power_task_end;
+        clock_gettime(CLOCK_MONOTONIC, &power_task_end);
+        unsigned long duration_us = (power_task_end.tv_sec - power_task_start.tv_sec) * 1000000UL +
+                                    (power_task_end.tv_nsec - power_task_start.tv_nsec) / 1000;
+        char signal_task_finish_on_cpu[TPM_MESSAGE_SIZE] = {0};
+        snprintf(signal_task_finish_on_cpu, TPM_MESSAGE_SIZE, "%s %u f %lu",
+                 task_name, power_task_cpu, duration_us);
+        TPM_zmq_send_signal(zmq_request, signal_task_finish_on_cpu);
+    }
+
     if (TPM_PAPI)
     {
         /* Stop PAPI counters */
@@ -209,6 +241,16 @@ extern void TPM_trace_task_finish(const char *task_name)
     pthread_mutex_unlock(&mutex);
 }
 
+extern void TPM_trace_energy(int window)
+{
+    if (TPM_POWER)
+    {
+        char signal[TPM_MESSAGE_SIZE] = {0};
+        snprintf(signal, sizeof(signal), "energy %d", window ? 0 : 1);
+        TPM_zmq_send_signal(zmq_request, signal);
+    }
+}
+
 extern void TPM_trace_finalize(double total_execution_time)
 {
     if (TPM_POWER)
@@ -220,6 +262,13 @@ extern void TPM_trace_finalize(double total_execution_time)
         free(signal_execution_time);
 
         TPM_zmq_close(zmq_request, zmq_context);
+
+        if (power_task_migrations > 0)
+        {
+            fprintf(stderr, "%lu tasks finished on another CPU than they started on, "
+                            "set OMP_PROC_BIND to pin the threads\n",
+                    power_task_migrations);
+        }
     }
 
     if (TPM_PAPI)